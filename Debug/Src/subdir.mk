@@ -5,40 +5,61 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../Src/dma.c \
 ../Src/gpio.c \
 ../Src/i2c.c \
+../Src/i2c_bus.c \
 ../Src/main.c \
+../Src/range_array.c \
+../Src/range_filter.c \
+../Src/range_sched.c \
+../Src/range_tracker.c \
 ../Src/stm32f1xx_hal_msp.c \
 ../Src/stm32f1xx_it.c \
 ../Src/syscalls.c \
 ../Src/sysmem.c \
 ../Src/system_stm32f1xx.c \
 ../Src/usart.c \
-../Src/vl53l0x.c 
+../Src/vl53l0x.c \
+../Src/vl53l0x_calib.c 
 
 OBJS += \
+./Src/dma.o \
 ./Src/gpio.o \
 ./Src/i2c.o \
+./Src/i2c_bus.o \
 ./Src/main.o \
+./Src/range_array.o \
+./Src/range_filter.o \
+./Src/range_sched.o \
+./Src/range_tracker.o \
 ./Src/stm32f1xx_hal_msp.o \
 ./Src/stm32f1xx_it.o \
 ./Src/syscalls.o \
 ./Src/sysmem.o \
 ./Src/system_stm32f1xx.o \
 ./Src/usart.o \
-./Src/vl53l0x.o 
+./Src/vl53l0x.o \
+./Src/vl53l0x_calib.o 
 
 C_DEPS += \
+./Src/dma.d \
 ./Src/gpio.d \
 ./Src/i2c.d \
+./Src/i2c_bus.d \
 ./Src/main.d \
+./Src/range_array.d \
+./Src/range_filter.d \
+./Src/range_sched.d \
+./Src/range_tracker.d \
 ./Src/stm32f1xx_hal_msp.d \
 ./Src/stm32f1xx_it.d \
 ./Src/syscalls.d \
 ./Src/sysmem.d \
 ./Src/system_stm32f1xx.d \
 ./Src/usart.d \
-./Src/vl53l0x.d 
+./Src/vl53l0x.d \
+./Src/vl53l0x_calib.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -48,7 +69,7 @@ Src/%.o Src/%.su Src/%.cyclo: ../Src/%.c Src/subdir.mk
 clean: clean-Src
 
 clean-Src:
-	-$(RM) ./Src/gpio.cyclo ./Src/gpio.d ./Src/gpio.o ./Src/gpio.su ./Src/i2c.cyclo ./Src/i2c.d ./Src/i2c.o ./Src/i2c.su ./Src/main.cyclo ./Src/main.d ./Src/main.o ./Src/main.su ./Src/stm32f1xx_hal_msp.cyclo ./Src/stm32f1xx_hal_msp.d ./Src/stm32f1xx_hal_msp.o ./Src/stm32f1xx_hal_msp.su ./Src/stm32f1xx_it.cyclo ./Src/stm32f1xx_it.d ./Src/stm32f1xx_it.o ./Src/stm32f1xx_it.su ./Src/syscalls.cyclo ./Src/syscalls.d ./Src/syscalls.o ./Src/syscalls.su ./Src/sysmem.cyclo ./Src/sysmem.d ./Src/sysmem.o ./Src/sysmem.su ./Src/system_stm32f1xx.cyclo ./Src/system_stm32f1xx.d ./Src/system_stm32f1xx.o ./Src/system_stm32f1xx.su ./Src/usart.cyclo ./Src/usart.d ./Src/usart.o ./Src/usart.su ./Src/vl53l0x.cyclo ./Src/vl53l0x.d ./Src/vl53l0x.o ./Src/vl53l0x.su
+	-$(RM) ./Src/dma.cyclo ./Src/dma.d ./Src/dma.o ./Src/dma.su ./Src/gpio.cyclo ./Src/gpio.d ./Src/gpio.o ./Src/gpio.su ./Src/i2c.cyclo ./Src/i2c.d ./Src/i2c.o ./Src/i2c.su ./Src/i2c_bus.cyclo ./Src/i2c_bus.d ./Src/i2c_bus.o ./Src/i2c_bus.su ./Src/main.cyclo ./Src/main.d ./Src/main.o ./Src/main.su ./Src/range_array.cyclo ./Src/range_array.d ./Src/range_array.o ./Src/range_array.su ./Src/range_filter.cyclo ./Src/range_filter.d ./Src/range_filter.o ./Src/range_filter.su ./Src/range_sched.cyclo ./Src/range_sched.d ./Src/range_sched.o ./Src/range_sched.su ./Src/range_tracker.cyclo ./Src/range_tracker.d ./Src/range_tracker.o ./Src/range_tracker.su ./Src/stm32f1xx_hal_msp.cyclo ./Src/stm32f1xx_hal_msp.d ./Src/stm32f1xx_hal_msp.o ./Src/stm32f1xx_hal_msp.su ./Src/stm32f1xx_it.cyclo ./Src/stm32f1xx_it.d ./Src/stm32f1xx_it.o ./Src/stm32f1xx_it.su ./Src/syscalls.cyclo ./Src/syscalls.d ./Src/syscalls.o ./Src/syscalls.su ./Src/sysmem.cyclo ./Src/sysmem.d ./Src/sysmem.o ./Src/sysmem.su ./Src/system_stm32f1xx.cyclo ./Src/system_stm32f1xx.d ./Src/system_stm32f1xx.o ./Src/system_stm32f1xx.su ./Src/usart.cyclo ./Src/usart.d ./Src/usart.o ./Src/usart.su ./Src/vl53l0x.cyclo ./Src/vl53l0x.d ./Src/vl53l0x.o ./Src/vl53l0x.su ./Src/vl53l0x_calib.cyclo ./Src/vl53l0x_calib.d ./Src/vl53l0x_calib.o ./Src/vl53l0x_calib.su
 
 .PHONY: clean-Src
 
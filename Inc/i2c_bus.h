@@ -0,0 +1,253 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx_hal.h"
+#include <stdbool.h>
+
+/* Transporte assíncrono do barramento I2C: DMA (I2C1 RX no DMA1 canal 7,
+   TX no canal 6) com conclusão por callback. Todos os clientes passam por uma
+   fila de transações com prioridade; as transferências são iniciadas só fora
+   de interrupção (pedido, espera bloqueante ou I2CBus_Process no loop) */
+#define I2C_BUS_DMA_MIN_RX          3       // Bytes - Leituras menores por interrupção (F1: 1 e 2 bytes)
+#define I2C_BUS_DMA_MIN_TX          3       // Bytes - Escritas menores por interrupção
+#define I2C_BUS_TX_BUFFER_SIZE      16      // Bytes - Maior escrita (copiada na fila)
+#define I2C_BUS_QUEUE_SIZE          8       // Transações na fila, incluindo a em andamento
+#define I2C_BUS_TIMEOUT             100     // ms - Prazo de uma transferência
+
+/* Velocidade do barramento (ClockSpeed do handle) */
+#define I2C_BUS_SPEED_STANDARD      100000  // Hz - Standard mode
+#define I2C_BUS_SPEED_FAST          400000  // Hz - Fast mode, máximo do VL53L0X
+#define I2C_BUS_FALLBACK_ERRORS     3       // Erros seguidos acima do standard mode antes de reduzir
+
+/* Recuperação de barramento travado: linhas do I2C1 usadas como GPIO */
+#define I2C_BUS_SCL_PORT            GPIOB
+#define I2C_BUS_SCL_PIN             GPIO_PIN_6
+#define I2C_BUS_SDA_PORT            GPIOB
+#define I2C_BUS_SDA_PIN             GPIO_PIN_7
+#define I2C_BUS_RECOVERY_PULSES     9       // Pulsos em SCL: o escravo conclui o byte e solta SDA
+#define I2C_BUS_HUNG_MS             2       // ms - BUSY ou SDA baixo com o barramento ocioso
+
+/* Contadores do barramento registrado */
+typedef struct {
+    uint32_t transfers;                  // Transferências concluídas
+    uint32_t nackErrors;                 // Sem ACK (endereço ou dado)
+    uint32_t arloErrors;                 // Perda de arbitragem
+    uint32_t busErrors;                  // START/STOP fora de lugar (BERR)
+    uint32_t timeouts;                   // Prazo esgotado ou linha presa
+    uint32_t fallbacks;                  // Reduções automáticas de velocidade
+    uint32_t recoveries;                 // Barramentos travados liberados
+    uint32_t recoveryFailures;           // Recuperações que não liberaram as linhas
+    uint32_t lastRecoveryMs;             // ms - Do primeiro erro até o barramento livre (última)
+    uint32_t maxRecoveryMs;              // ms - Maior tempo de recuperação
+} I2CBus_Stats;
+
+/* Conclusão de uma transferência assíncrona, em contexto de interrupção */
+typedef void (*I2CBus_Callback)(void *context, HAL_StatusTypeDef status);
+
+/* Prioridade do cliente: a fila serve a maior primeiro, em ordem de chegada
+   dentro da mesma prioridade */
+typedef enum {
+    I2C_BUS_PRIORITY_HIGH = 0,           // Leitura de amostras (latência determinística)
+    I2C_BUS_PRIORITY_NORMAL,             // Configuração e chamadas bloqueantes
+    I2C_BUS_PRIORITY_LOW,                // Tarefas de fundo (varredura)
+    I2C_BUS_PRIORITY_COUNT
+} I2CBus_Priority;
+
+/* Tipo de transação */
+typedef enum {
+    I2C_BUS_OP_WRITE = 0,                // Índice + dados
+    I2C_BUS_OP_READ,                     // Índice, repeated start e leitura
+    I2C_BUS_OP_PROBE                     // Endereço com leitura de 1 byte (ACK = presente)
+} I2CBus_Op;
+
+/* Descritor de transação (copiado pela fila) */
+typedef struct {
+    I2CBus_Op op;
+    I2CBus_Priority priority;
+    uint8_t address;                     // Endereço 7-bit
+    uint8_t reg;                         // Primeiro registrador (ignorado em PROBE)
+    uint8_t *data;                       // Destino da leitura / dados da escrita (copiados)
+    uint16_t count;                      // Bytes (ignorado em PROBE)
+    I2CBus_Callback callback;            // Conclusão ou erro (pode ser NULL)
+    void *context;                       // Repassado ao callback
+} I2CBus_Transaction;
+
+/**
+ * @brief Register the handle served by the asynchronous transport
+ * @note The handle must have its DMA channels linked (hdmarx/hdmatx) and the
+ *       I2C event/error and DMA interrupts enabled. Other handles, or this
+ *       one before the call, only get the blocking path
+ * @param hi2c Pointer to I2C handle
+ */
+void I2CBus_Init(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief Check if a transaction is queued or in flight
+ * @param hi2c Pointer to I2C handle
+ * @return true until the queue is empty
+ */
+bool I2CBus_IsBusy(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief Wait for the queue to empty
+ * @note A transfer in flight for more than timeout_ms is abandoned through
+ *       I2CBus_Recover and its callback gets HAL_TIMEOUT
+ * @param hi2c Pointer to I2C handle
+ * @param timeout_ms Maximum duration of one transfer in ms
+ * @return HAL_OK when the bus is free, HAL_TIMEOUT otherwise
+ */
+HAL_StatusTypeDef I2CBus_WaitIdle(I2C_HandleTypeDef *hi2c, uint32_t timeout_ms);
+
+/**
+ * @brief Queue a transaction and return immediately
+ * @note Transactions are started from thread context only: here when the
+ *       bus is free, otherwise by I2CBus_Process or a blocking call once the
+ *       transfer in flight completes. The F1 HAL busy-waits the START and
+ *       address phase against HAL_GetTick, which does not advance inside
+ *       the I2C/DMA interrupts (priority 0, above SysTick), so a stretched
+ *       or hung bus would lock the MCU there. Highest priority first, FIFO
+ *       within a priority. Reads
+ *       use DMA from I2C_BUS_DMA_MIN_RX bytes and interrupt mode below it,
+ *       since the F1 must program ACK/POS before ADDR is cleared for 1 and
+ *       2 byte receptions; writes likewise from I2C_BUS_DMA_MIN_TX. Write
+ *       data is copied; a read destination must stay valid until the
+ *       callback. A NACK on PROBE is not counted as a bus error. May be
+ *       called from a completion callback (queued only)
+ * @param hi2c Pointer to I2C handle
+ * @param transaction Descriptor (copied)
+ * @return HAL_OK if queued, HAL_BUSY if the queue is full, HAL_ERROR if the
+ *         handle has no asynchronous transport or the descriptor is invalid
+ */
+HAL_StatusTypeDef I2CBus_Submit(I2C_HandleTypeDef *hi2c, const I2CBus_Transaction *transaction);
+
+/**
+ * @brief Queue a register read and return immediately
+ * @note Shorthand for I2CBus_Submit with I2C_BUS_OP_READ
+ * @param hi2c Pointer to I2C handle
+ * @param priority Queue priority of the client
+ * @param address 7-bit device address
+ * @param reg First register (8-bit index)
+ * @param data Destination buffer (valid until the callback)
+ * @param count Number of bytes
+ * @param callback Called on completion or error (may be NULL)
+ * @param context Passed to callback
+ * @return HAL_StatusTypeDef as I2CBus_Submit
+ */
+HAL_StatusTypeDef I2CBus_ReadAsync(I2C_HandleTypeDef *hi2c, I2CBus_Priority priority, uint8_t address, uint8_t reg,
+                                   uint8_t *data, uint16_t count, I2CBus_Callback callback, void *context);
+
+/**
+ * @brief Queue a register write and return immediately
+ * @note Shorthand for I2CBus_Submit with I2C_BUS_OP_WRITE; data is copied,
+ *       so the caller may reuse it at once
+ * @param hi2c Pointer to I2C handle
+ * @param priority Queue priority of the client
+ * @param address 7-bit device address
+ * @param reg First register (8-bit index)
+ * @param data Bytes to write
+ * @param count Number of bytes (<= I2C_BUS_TX_BUFFER_SIZE)
+ * @param callback Called on completion or error (may be NULL)
+ * @param context Passed to callback
+ * @return HAL_StatusTypeDef as I2CBus_Submit
+ */
+HAL_StatusTypeDef I2CBus_WriteAsync(I2C_HandleTypeDef *hi2c, I2CBus_Priority priority, uint8_t address, uint8_t reg,
+                                    const uint8_t *data, uint16_t count, I2CBus_Callback callback, void *context);
+
+/**
+ * @brief Read registers, waiting for completion
+ * @note Queued at I2C_BUS_PRIORITY_NORMAL; the caller spins (thread context
+ *       only) while higher-priority readouts are served. Handles without
+ *       the asynchronous transport use the blocking HAL call
+ * @param hi2c Pointer to I2C handle
+ * @param address 7-bit device address
+ * @param reg First register (8-bit index)
+ * @param data Destination buffer
+ * @param count Number of bytes
+ * @return HAL_StatusTypeDef
+ */
+HAL_StatusTypeDef I2CBus_Read(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t count);
+
+/**
+ * @brief Write registers, waiting for completion
+ * @note Queued at I2C_BUS_PRIORITY_NORMAL, as I2CBus_Read
+ * @param hi2c Pointer to I2C handle
+ * @param address 7-bit device address
+ * @param reg First register (8-bit index)
+ * @param data Bytes to write
+ * @param count Number of bytes (<= I2C_BUS_TX_BUFFER_SIZE)
+ * @return HAL_StatusTypeDef
+ */
+HAL_StatusTypeDef I2CBus_Write(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, const uint8_t *data, uint16_t count);
+
+/**
+ * @brief Check if a device acknowledges its address, waiting for completion
+ * @note Queued at I2C_BUS_PRIORITY_LOW as I2C_BUS_OP_PROBE (thread context
+ *       only)
+ * @param hi2c Pointer to I2C handle
+ * @param address 7-bit device address
+ * @return HAL_OK if the device answered
+ */
+HAL_StatusTypeDef I2CBus_Probe(I2C_HandleTypeDef *hi2c, uint8_t address);
+
+/**
+ * @brief Queue housekeeping, called from the main loop
+ * @note Interrupt and DMA transfers have no HAL timeout: a transfer in
+ *       flight for I2C_BUS_TIMEOUT is abandoned through I2CBus_Recover.
+ *       Also starts the next queued transaction, since completion
+ *       interrupts do not chain transfers
+ * @param hi2c Pointer to I2C handle
+ */
+void I2CBus_Process(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief Release a hung bus and reinitialize the peripheral
+ * @note Called automatically when BUSY stays set or SDA stays low with the
+ *       bus idle for I2C_BUS_HUNG_MS (checked before each transfer and after
+ *       a busy/timeout failure). Drives SCL as GPIO for up to
+ *       I2C_BUS_RECOVERY_PULSES clocks until the slave releases SDA, issues a
+ *       STOP and runs HAL_I2C_DeInit/HAL_I2C_Init (keeping the current speed),
+ *       whose software reset clears the latched BUSY flag of the F1. The
+ *       transfer in flight, if any, completes with HAL_TIMEOUT; the rest of
+ *       the queue is kept
+ * @param hi2c Pointer to I2C handle
+ * @return HAL_OK if both lines are free afterwards
+ */
+HAL_StatusTypeDef I2CBus_Recover(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief Change the bus clock at run time
+ * @note Waits for the queue to empty, then reprograms CCR/TRISE through
+ *       HAL_I2C_Init. The duty cycle only matters above the standard mode
+ * @param hi2c Pointer to I2C handle
+ * @param clock_hz SCL frequency (1 to I2C_BUS_SPEED_FAST)
+ * @param duty_cycle I2C_DUTYCYCLE_2 or I2C_DUTYCYCLE_16_9
+ * @return HAL_StatusTypeDef
+ */
+HAL_StatusTypeDef I2CBus_SetSpeed(I2C_HandleTypeDef *hi2c, uint32_t clock_hz, uint32_t duty_cycle);
+
+/**
+ * @brief Enable or disable the automatic speed fallback
+ * @note Enabled by I2CBus_Init. With I2C_BUS_FALLBACK_ERRORS consecutive
+ *       NACK/ARLO/BERR/timeout errors above I2C_BUS_SPEED_STANDARD, the next
+ *       transfer starts at the standard mode
+ * @param hi2c Pointer to I2C handle
+ * @param enable true to allow the fallback
+ */
+void I2CBus_SetFallback(I2C_HandleTypeDef *hi2c, bool enable);
+
+/**
+ * @brief Get the transfer and error counters of the registered bus
+ * @param hi2c Pointer to I2C handle
+ * @param stats Pointer to store the counters (zeroed for other handles)
+ */
+void I2CBus_GetStats(I2C_HandleTypeDef *hi2c, I2CBus_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* I2C_BUS_H */
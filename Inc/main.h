@@ -59,6 +59,26 @@ void Error_Handler(void);
 /* Private defines -----------------------------------------------------------*/
 #define LED_AZUL_Pin GPIO_PIN_13
 #define LED_AZUL_GPIO_Port GPIOC
+#define VL53L0X_GPIO1_Pin GPIO_PIN_0
+#define VL53L0X_GPIO1_GPIO_Port GPIOB
+#define VL53L0X_GPIO1_EXTI_IRQn EXTI0_IRQn
+#define VL53L0X_S2_GPIO1_Pin GPIO_PIN_1
+#define VL53L0X_S2_GPIO1_GPIO_Port GPIOB
+#define VL53L0X_S2_GPIO1_EXTI_IRQn EXTI1_IRQn
+#define VL53L0X_S3_GPIO1_Pin GPIO_PIN_10
+#define VL53L0X_S3_GPIO1_GPIO_Port GPIOB
+#define VL53L0X_S3_GPIO1_EXTI_IRQn EXTI15_10_IRQn
+#define VL53L0X_S4_GPIO1_Pin GPIO_PIN_11
+#define VL53L0X_S4_GPIO1_GPIO_Port GPIOB
+#define VL53L0X_S4_GPIO1_EXTI_IRQn EXTI15_10_IRQn
+#define VL53L0X_XSHUT1_Pin GPIO_PIN_12
+#define VL53L0X_XSHUT1_GPIO_Port GPIOB
+#define VL53L0X_XSHUT2_Pin GPIO_PIN_13
+#define VL53L0X_XSHUT2_GPIO_Port GPIOB
+#define VL53L0X_XSHUT3_Pin GPIO_PIN_14
+#define VL53L0X_XSHUT3_GPIO_Port GPIOB
+#define VL53L0X_XSHUT4_Pin GPIO_PIN_15
+#define VL53L0X_XSHUT4_GPIO_Port GPIOB
 
 /* USER CODE BEGIN Private defines */
 
@@ -0,0 +1,99 @@
+#ifndef RANGE_ARRAY_H
+#define RANGE_ARRAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vl53l0x.h"
+#include "range_tracker.h"
+#include <stdbool.h>
+
+/* Conjunto de sensores VL53L0X no mesmo barramento, um XSHUT por sensor */
+#define RANGE_ARRAY_MAX_SENSORS     4
+#define RANGE_ARRAY_BASE_ADDRESS    0x30    // Sensor i recebe RANGE_ARRAY_BASE_ADDRESS + i
+
+/* Posição do conjunto */
+typedef struct {
+    VL53L0X_Dev dev;                     // Handle do sensor
+    GPIO_TypeDef *xshutPort;             // Linha XSHUT (ativa baixa)
+    uint16_t xshutPin;
+    uint16_t gpio1Pin;                   // Linha EXTI de GPIO1 (data-ready)
+    bool online;                         // Respondeu no boot e recebeu endereço
+    bool startPending;                   // Aguardando sua fase no escalonamento
+    uint32_t startTick;                  // Instante (HAL tick) de início do modo temporizado
+    uint16_t lastDistance_mm;            // Última distância filtrada
+    RangeTracker tracker;                // Distância, velocidade e predição
+} RangeArray_Sensor;
+
+/**
+ * @brief Bring up the sensors one at a time and give each a unique address
+ * @note Holds every XSHUT low, then releases them in order; a sensor found at
+ *       0x29 is moved to RANGE_ARRAY_BASE_ADDRESS + index. A sensor already
+ *       at its target address (XSHUT not wired, MCU reset) is accepted as is
+ * @param hi2c Pointer to I2C handle shared by the sensors
+ * @return Number of sensors online
+ */
+uint8_t RangeArray_Init(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief Get the number of sensors online
+ * @return Sensor count
+ */
+uint8_t RangeArray_GetCount(void);
+
+/**
+ * @brief Get a sensor slot
+ * @param index Slot index (< RANGE_ARRAY_MAX_SENSORS)
+ * @return Pointer to the slot, or NULL if index is out of range
+ */
+RangeArray_Sensor *RangeArray_GetSensor(uint8_t index);
+
+/**
+ * @brief Schedule timed-mode ranging with the sensors phase-shifted
+ * @note Sensor k of N starts period_ms * k / N after the first, so each
+ *       readout happens while the others are still ranging. Starts are
+ *       issued by RangeArray_Process, never blocking the caller
+ * @param period_ms Inter-measurement period of every sensor in ms
+ */
+void RangeArray_StartStaggered(uint32_t period_ms);
+
+/**
+ * @brief Issue the scheduled starts that are due
+ * @note Call from the main loop
+ * @return VL53L0X_ERROR if a sensor failed to start
+ */
+VL53L0X_Status RangeArray_Process(void);
+
+/**
+ * @brief Stop ranging on every sensor online
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status RangeArray_StopAll(void);
+
+/**
+ * @brief Stop and reschedule the staggered ranging with the last period
+ * @note Used after a bus recovery: a reading lost on the hung bus leaves the
+ *       sensor interrupt latched, and StartContinuous clears it
+ * @return VL53L0X_ERROR if a sensor failed to stop
+ */
+VL53L0X_Status RangeArray_Restart(void);
+
+/**
+ * @brief Forward a GPIO1 EXTI event to the matching sensor
+ * @note Called from HAL_GPIO_EXTI_Callback (interrupt context)
+ * @param gpio_pin Pin that triggered the interrupt
+ */
+void RangeArray_DataReadyCallback(uint16_t gpio_pin);
+
+/**
+ * @brief Get the shortest last distance among the sensors online
+ * @return Distance in mm (0xFFFF if no sensor is online)
+ */
+uint16_t RangeArray_GetNearestDistance(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RANGE_ARRAY_H */
@@ -0,0 +1,128 @@
+#ifndef RANGE_FILTER_H
+#define RANGE_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Cadeia de filtros de distância: estágios encadeados com memória estática e
+   custo por amostra limitado pelo tamanho máximo da janela */
+#define RANGE_FILTER_MAX_STAGES         4
+#define RANGE_FILTER_MAX_WINDOW         7       // Janela máxima de mediana/Hampel
+#define RANGE_FILTER_HAMPEL_MIN_MM      10      // mm - Limiar mínimo do Hampel (janela constante, MAD = 0)
+
+/* Tipo de estágio */
+typedef enum {
+    RANGE_FILTER_GATE = 0,       // Salto máximo + leituras consecutivas
+    RANGE_FILTER_MEDIAN,         // Mediana das últimas N amostras
+    RANGE_FILTER_HAMPEL,         // Substitui outliers (> k * MAD) pela mediana
+    RANGE_FILTER_EMA             // Média móvel exponencial ponderada por sigma
+} RangeFilter_StageType;
+
+/* Estágio da cadeia: configuração e estado */
+typedef struct {
+    RangeFilter_StageType type;
+    uint16_t param;                      // GATE: salto (mm); MEDIAN/HAMPEL: janela; EMA: alfa (Q8)
+    uint16_t param2;                     // GATE: leituras; HAMPEL: k (décimos); EMA: sigma de referência (mm)
+    uint16_t ring[RANGE_FILTER_MAX_WINDOW];      // Amostras na ordem de chegada
+    uint16_t sorted[RANGE_FILTER_MAX_WINDOW];    // Mesmas amostras ordenadas
+    uint8_t head;                        // Próxima posição do anel
+    uint8_t fill;                        // Amostras na janela
+    uint8_t count;                       // GATE: leituras consistentes seguidas
+    uint16_t last;                       // GATE: amostra anterior
+    uint32_t ema;                        // EMA: saída (mm, Q8)
+} RangeFilter_Stage;
+
+/* Cadeia completa */
+typedef struct {
+    RangeFilter_Stage stages[RANGE_FILTER_MAX_STAGES];
+    uint8_t count;
+} RangeFilter;
+
+/**
+ * @brief Empty the chain (samples pass through unchanged)
+ * @param filter Pointer to the chain
+ */
+void RangeFilter_Init(RangeFilter *filter);
+
+/**
+ * @brief Append a jump/consecutive gate stage
+ * @note Passes a sample once valid_reads consecutive samples stayed within
+ *       max_jump_mm of each other. A jump re-anchors the gate on the new
+ *       level instead of rejecting it forever
+ * @param filter Pointer to the chain
+ * @param max_jump_mm Maximum difference between consecutive samples
+ * @param valid_reads Consecutive consistent samples before output (>= 1)
+ * @return false if the chain is full or the parameters are invalid
+ */
+bool RangeFilter_AddGate(RangeFilter *filter, uint16_t max_jump_mm, uint8_t valid_reads);
+
+/**
+ * @brief Append a median-of-N stage
+ * @param filter Pointer to the chain
+ * @param size Window size (1 to RANGE_FILTER_MAX_WINDOW)
+ * @return false if the chain is full or the parameters are invalid
+ */
+bool RangeFilter_AddMedian(RangeFilter *filter, uint8_t size);
+
+/**
+ * @brief Append a Hampel outlier stage
+ * @note A sample further than k * 1.4826 * MAD from the window median (at
+ *       least RANGE_FILTER_HAMPEL_MIN_MM) is replaced by the median
+ * @param filter Pointer to the chain
+ * @param size Window size (3 to RANGE_FILTER_MAX_WINDOW)
+ * @param k_tenths Threshold k in tenths (30 = 3.0)
+ * @return false if the chain is full or the parameters are invalid
+ */
+bool RangeFilter_AddHampel(RangeFilter *filter, uint8_t size, uint8_t k_tenths);
+
+/**
+ * @brief Append an exponential moving average stage
+ * @note With sigma_ref_mm > 0 the gain is scaled by sigma_ref / (sigma_ref +
+ *       sigma), so confident samples converge faster than noisy ones
+ * @param filter Pointer to the chain
+ * @param alpha_q8 Gain in Q8 (1 to 256; 256 = no smoothing)
+ * @param sigma_ref_mm Sigma weighting reference, 0 to disable
+ * @return false if the chain is full or the parameters are invalid
+ */
+bool RangeFilter_AddEma(RangeFilter *filter, uint16_t alpha_q8, uint16_t sigma_ref_mm);
+
+/**
+ * @brief Update the parameters of every gate stage in the chain
+ * @param filter Pointer to the chain
+ * @param max_jump_mm Maximum difference between consecutive samples
+ * @param valid_reads Consecutive consistent samples before output
+ */
+void RangeFilter_SetGate(RangeFilter *filter, uint16_t max_jump_mm, uint8_t valid_reads);
+
+/**
+ * @brief Clear the state of every stage, keeping the configuration
+ * @param filter Pointer to the chain
+ */
+void RangeFilter_Reset(RangeFilter *filter);
+
+/**
+ * @brief Report a rejected sample (status, signal or sigma)
+ * @note Breaks the consecutive count of the gate stages
+ * @param filter Pointer to the chain
+ */
+void RangeFilter_Invalidate(RangeFilter *filter);
+
+/**
+ * @brief Run one valid sample through the chain
+ * @param filter Pointer to the chain
+ * @param distance_mm Measured distance
+ * @param sigma_mm Sample uncertainty (VL53L0X_RangingData.sigma)
+ * @param output Filtered distance, written only when the function returns true
+ * @return true if the chain produced an output for this sample
+ */
+bool RangeFilter_Process(RangeFilter *filter, uint16_t distance_mm, uint16_t sigma_mm, uint16_t *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RANGE_FILTER_H */
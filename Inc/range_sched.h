@@ -0,0 +1,78 @@
+#ifndef RANGE_SCHED_H
+#define RANGE_SCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Escalonador de amostragem por movimento: taxa lenta com a cena parada,
+   taxa máxima quando alguma distância muda além do limiar */
+#define RANGE_SCHED_MAX_CHANNELS        4       // Sensores acompanhados
+
+/* Taxa pedida pelo escalonador */
+typedef enum {
+    RANGE_SCHED_IDLE = 0,        // Cena parada: período longo
+    RANGE_SCHED_ACTIVE           // Movimento: perfil mais rápido
+} RangeSched_State;
+
+/* Configuração */
+typedef struct {
+    uint16_t thresholdMm;                // mm - Variação que indica movimento
+    uint32_t attackMs;                   // ms - Movimento sustentado antes de acelerar (0 = imediato)
+    uint32_t decayMs;                    // ms - Sem movimento antes de desacelerar
+} RangeSched_Config;
+
+/* Estado do escalonador */
+typedef struct {
+    RangeSched_Config config;
+    RangeSched_State state;
+    uint16_t reference[RANGE_SCHED_MAX_CHANNELS];    // Distância de referência de cada canal
+    uint8_t referenceValid;              // Bit por canal com referência
+    bool attackPending;                  // Movimento visto em IDLE, aguardando attackMs
+    uint32_t attackTick;                 // HAL tick do primeiro movimento em IDLE
+    uint32_t motionTick;                 // HAL tick do último movimento
+} RangeSched;
+
+/**
+ * @brief Configure the scheduler and start in RANGE_SCHED_IDLE
+ * @param sched Pointer to the scheduler
+ * @param config Threshold, attack and decay times
+ */
+void RangeSched_Init(RangeSched *sched, const RangeSched_Config *config);
+
+/**
+ * @brief Return to RANGE_SCHED_IDLE and forget the references
+ * @param sched Pointer to the scheduler
+ */
+void RangeSched_Reset(RangeSched *sched);
+
+/**
+ * @brief Feed one filtered distance of a channel
+ * @note A change beyond thresholdMm from the channel reference is motion and
+ *       moves the reference. In IDLE, motion switches to ACTIVE at once
+ *       (attackMs = 0) or once motion is seen again attackMs after the
+ *       first one. In ACTIVE, decayMs without motion on any channel returns
+ *       to IDLE
+ * @param sched Pointer to the scheduler
+ * @param channel Sensor index (< RANGE_SCHED_MAX_CHANNELS)
+ * @param distance_mm Filtered distance
+ * @param timestamp HAL tick of the sample
+ * @return true if the state changed; read it with RangeSched_GetState
+ */
+bool RangeSched_Update(RangeSched *sched, uint8_t channel, uint16_t distance_mm, uint32_t timestamp);
+
+/**
+ * @brief Get the rate requested by the scheduler
+ * @param sched Pointer to the scheduler
+ * @return RangeSched_State
+ */
+RangeSched_State RangeSched_GetState(const RangeSched *sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RANGE_SCHED_H */
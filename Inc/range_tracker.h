@@ -0,0 +1,78 @@
+#ifndef RANGE_TRACKER_H
+#define RANGE_TRACKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vl53l0x.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Rastreador alfa-beta 1D de velocidade constante, em ponto fixo (mm Q8, mm/s Q8) */
+#define RANGE_TRACKER_ALPHA             128     // Q8 - Ganho de posição para amostra ideal (0.5)
+#define RANGE_TRACKER_SIGMA_REF_MM      20      // mm - Sigma em que o ganho cai à metade
+#define RANGE_TRACKER_SIGNAL_REF        VL53L0X_FP97(1.0)   // Sinal a partir do qual o ganho é pleno (9.7)
+#define RANGE_TRACKER_MAX_GAP_MS        2500    // ms - Intervalo sem amostras que reinicia o rastreio (> período mais lento, com folga para uma amostra perdida)
+#define RANGE_TRACKER_MAX_PREDICT_MS    1000    // ms - Horizonte máximo de predição
+#define RANGE_TRACKER_RESET_MM          500     // mm - Resíduo que indica troca de alvo
+#define RANGE_TRACKER_RESET_COUNT       2       // Resíduos grandes seguidos antes de reiniciar
+#define RANGE_TRACKER_MAX_SPEED         10000   // mm/s - Saturação da velocidade
+
+/* Estado do rastreador */
+typedef struct {
+    int32_t position;            // mm, Q8
+    int32_t velocity;            // mm/s, Q8 (negativa quando o alvo se aproxima)
+    uint32_t timestamp;          // HAL tick da última amostra aceita
+    uint8_t outliers;            // Resíduos grandes seguidos
+    bool initialized;
+} RangeTracker;
+
+/**
+ * @brief Clear the tracker; the next sample initializes it
+ * @param tracker Pointer to the tracker
+ */
+void RangeTracker_Init(RangeTracker *tracker);
+
+/**
+ * @brief Feed one sample
+ * @note Gains scale with sigma and signal rate, so weak or uncertain samples
+ *       move the estimate less. Samples dropped by the status policy or
+ *       with no return are ignored (the tracker coasts). A gap longer than
+ *       RANGE_TRACKER_MAX_GAP_MS or RANGE_TRACKER_RESET_COUNT residuals over
+ *       RANGE_TRACKER_RESET_MM restart the track on the new sample
+ * @param tracker Pointer to the tracker
+ * @param ranging_data Sample, timestamped by VL53L0X_FetchMeasurement
+ * @return true if the sample was used
+ */
+bool RangeTracker_Update(RangeTracker *tracker, const VL53L0X_RangingData *ranging_data);
+
+/**
+ * @brief Get the estimated range at the last sample
+ * @param tracker Pointer to the tracker
+ * @return Range in mm (0 if not initialized)
+ */
+uint16_t RangeTracker_GetRange(const RangeTracker *tracker);
+
+/**
+ * @brief Get the estimated velocity
+ * @param tracker Pointer to the tracker
+ * @return Velocity in mm/s, negative while the target approaches
+ */
+int16_t RangeTracker_GetVelocity(const RangeTracker *tracker);
+
+/**
+ * @brief Predict the range at an arbitrary time
+ * @note Extrapolates at constant velocity, at most RANGE_TRACKER_MAX_PREDICT_MS
+ *       ahead; use HAL_GetTick() to hide the sample latency
+ * @param tracker Pointer to the tracker
+ * @param timestamp HAL tick of the prediction
+ * @return Range in mm, clamped to 0..VL53L0X_THRESHOLD_MAX_MM
+ */
+uint16_t RangeTracker_Predict(const RangeTracker *tracker, uint32_t timestamp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RANGE_TRACKER_H */
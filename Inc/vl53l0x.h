@@ -6,24 +6,59 @@ extern "C" {
 #endif
 
 #include "stm32f1xx_hal.h"
+#include "vl53l0x_fixed.h"
+#include "range_filter.h"
+#include <stdbool.h>
 
 /* VL53L0X I2C Device Address */
 #define VL53L0X_DEFAULT_ADDRESS    0x29
+#define VL53L0X_MODEL_ID           0xEE
+#define VL53L0X_BOOT_TIMEOUT       100     // ms - Prazo para o sensor responder após o boot
+#define VL53L0X_I2C_TIMEOUT        100     // ms - Prazo de cada transação I2C na HAL
 
-/* Configurações de timing e precisão */
+/* Alimentação do I/O: 1 = 2V8 (módulos com regulador), 0 = 1V8 */
+#define VL53L0X_IO_2V8             1
+
+/* Configurações de timing e precisão (valores do perfil "balanceada", o default) */
 #define VL53L0X_HIGH_ACCURACY_TIMING_BUDGET   200000  // 200ms
-#define VL53L0X_SIGNAL_RATE_LIMIT            0.25    // mcps
+#define VL53L0X_SIGNAL_RATE_LIMIT            VL53L0X_FP97(0.25)  // 0.25 mcps (9.7)
 #define VL53L0X_SIGMA_LIMIT                  60      // mm
+#define VL53L0X_SIGMA_MAX                    655     // mm - Estimativa saturada (sem eventos de sinal)
 #define VL53L0X_VALID_READS_BEFORE_UPDATE    3       // Número de leituras válidas antes de atualizar
 #define VL53L0X_MAX_MEASUREMENT_JUMP         100     // mm - Máxima variação permitida entre medidas
+#define VL53L0X_MEASUREMENT_TIMEOUT          100     // ticks (ms) - Margem além do budget/período para concluir uma medição
+
+/* Status da medição: código do dispositivo agrupado como na API da ST,
+   mais os limites de sinal e sigma do perfil */
+typedef enum {
+    VL53L0X_RANGE_VALID = 0,         // Medição válida
+    VL53L0X_RANGE_SIGMA_FAIL,        // Incerteza acima do limite (SNR ou sigma)
+    VL53L0X_RANGE_SIGNAL_FAIL,       // Sinal fraco ou sem alvo
+    VL53L0X_RANGE_MIN_RANGE_FAIL,    // Alvo abaixo do alcance mínimo (TCC, min clip)
+    VL53L0X_RANGE_PHASE_FAIL,        // Fase inconsistente entre etapas
+    VL53L0X_RANGE_HARDWARE_FAIL,     // Falha de VCSEL/VHV
+    VL53L0X_RANGE_WRAP_AROUND,       // Estouro do algoritmo (alvo além do alcance não ambíguo)
+    VL53L0X_RANGE_STATUS_COUNT
+} VL53L0X_RangeStatus;
+
+/* Tratamento de cada status em VL53L0X_FetchMeasurement / VL53L0X_FilterMeasurement */
+typedef enum {
+    VL53L0X_POLICY_DROP = 0,         // Descarta a amostra
+    VL53L0X_POLICY_ACCEPT_FLAGGED,   // Aceita, com flagged = true
+    VL53L0X_POLICY_RETRY             // Descarta e mede de novo imediatamente (uma vez)
+} VL53L0X_StatusPolicy;
 
 /* Estrutura para dados de medição */
 typedef struct {
     uint16_t distance_mm;        // Distância em milímetros
     uint16_t signalRate;         // Taxa de sinal de retorno
     uint16_t ambientRate;        // Taxa de luz ambiente
-    uint8_t rangeStatus;         // Status da medição
-    uint8_t sigma;               // Estimativa de precisão
+    uint16_t effectiveSpadCount; // SPADs de retorno efetivos (8.8)
+    uint8_t rangeStatus;         // Status da medição (VL53L0X_RangeStatus)
+    uint8_t deviceStatus;        // Código bruto do dispositivo (0-15, 11 = completa)
+    bool flagged;                // Status não válido aceito pela política
+    uint16_t sigma;              // Incerteza estimada da distância (mm, 1 desvio padrão)
+    uint32_t timestamp;          // HAL tick do fim da medição (borda de GPIO1)
 } VL53L0X_RangingData;
 
 /* VL53L0X Register Addresses */
@@ -38,6 +73,148 @@ typedef struct {
 #define VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG_GPIO     0x0A
 #define VL53L0X_REG_GPIO_HV_MUX_ACTIVE_HIGH         0x84
 #define VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR           0x0B
+#define VL53L0X_REG_RESULT_INTERRUPT_STATUS          0x13
+#define VL53L0X_REG_OSC_CALIBRATE_VAL                0xF8
+#define VL53L0X_REG_IDENTIFICATION_MODEL_ID          0xC0
+#define VL53L0X_REG_VHV_CONFIG_PAD_SCL_SDA_EXTSUP_HV 0x89
+#define VL53L0X_REG_I2C_SLAVE_DEVICE_ADDRESS         0x8A
+#define VL53L0X_REG_MSRC_CONFIG_CONTROL              0x60
+#define VL53L0X_REG_MSRC_CONFIG_TIMEOUT_MACROP       0x46
+#define VL53L0X_REG_FINAL_RANGE_CONFIG_MIN_COUNT_RATE_RTN_LIMIT 0x44
+#define VL53L0X_REG_PRE_RANGE_CONFIG_VCSEL_PERIOD    0x50
+#define VL53L0X_REG_PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI 0x51
+#define VL53L0X_REG_FINAL_RANGE_CONFIG_VCSEL_PERIOD  0x70
+#define VL53L0X_REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI 0x71
+#define VL53L0X_REG_PRE_RANGE_CONFIG_VALID_PHASE_LOW 0x56
+#define VL53L0X_REG_PRE_RANGE_CONFIG_VALID_PHASE_HIGH 0x57
+#define VL53L0X_REG_FINAL_RANGE_CONFIG_VALID_PHASE_LOW 0x47
+#define VL53L0X_REG_FINAL_RANGE_CONFIG_VALID_PHASE_HIGH 0x48
+#define VL53L0X_REG_GLOBAL_CONFIG_VCSEL_WIDTH        0x32
+#define VL53L0X_REG_ALGO_PHASECAL_CONFIG_TIMEOUT     0x30
+#define VL53L0X_REG_ALGO_PHASECAL_LIM                0x30   // Página 1 (0xFF = 0x01)
+#define VL53L0X_REG_GLOBAL_CONFIG_SPAD_ENABLES_REF_0 0xB0
+#define VL53L0X_REG_GLOBAL_CONFIG_REF_EN_START_SELECT 0xB6
+#define VL53L0X_REG_DYNAMIC_SPAD_NUM_REQUESTED_REF_SPAD 0x4E
+#define VL53L0X_REG_DYNAMIC_SPAD_REF_EN_START_OFFSET 0x4F
+#define VL53L0X_REG_ALGO_PART_TO_PART_RANGE_OFFSET_MM 0x28
+#define VL53L0X_REG_VHV_SETTINGS                     0xCB
+#define VL53L0X_REG_PHASE_CAL                        0xEE
+
+/* Bits de VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG */
+#define VL53L0X_SEQUENCE_ENABLE_TCC                  0x10
+#define VL53L0X_SEQUENCE_ENABLE_DSS                  0x08
+#define VL53L0X_SEQUENCE_ENABLE_MSRC                 0x04
+#define VL53L0X_SEQUENCE_ENABLE_PRE_RANGE            0x40
+#define VL53L0X_SEQUENCE_ENABLE_FINAL_RANGE          0x80
+#define VL53L0X_SEQUENCE_DEFAULT                     0xE8   // DSS, pre-range e final-range (MSRC e TCC desligados)
+
+/* Cópia em RAM dos registradores de configuração da página 0 (ver shadow_ranges em vl53l0x.c) */
+#define VL53L0X_SHADOW_SIZE                          39
+
+/* Limites do timing budget (µs) */
+#define VL53L0X_MIN_TIMING_BUDGET                    20000
+#define VL53L0X_MAX_TIMING_BUDGET                    1000000     // Timeout do final range cabe nos 16 bits codificados mesmo com VCSEL de 8 PCLKs (~2s)
+
+/* Períodos de pulso do VCSEL (PCLKs, apenas valores pares) */
+#define VL53L0X_PRE_RANGE_VCSEL_PERIOD_MIN           12
+#define VL53L0X_PRE_RANGE_VCSEL_PERIOD_MAX           18
+#define VL53L0X_PRE_RANGE_VCSEL_PERIOD_DEFAULT       14
+#define VL53L0X_FINAL_RANGE_VCSEL_PERIOD_MIN         8
+#define VL53L0X_FINAL_RANGE_VCSEL_PERIOD_MAX         14
+#define VL53L0X_FINAL_RANGE_VCSEL_PERIOD_DEFAULT     10
+
+/* Bloco de resultado (leitura única com auto-incremento a partir de 0x14) */
+#define VL53L0X_RESULT_BLOCK_SIZE                    12
+#define VL53L0X_RESULT_OFFSET_STATUS                 0   // 0x14
+#define VL53L0X_RESULT_DEVICE_STATUS_MASK            0x78 // Bits 6:3 do status
+#define VL53L0X_RESULT_DEVICE_STATUS_SHIFT           3
+#define VL53L0X_RESULT_OFFSET_EFFECTIVE_SPADS        2   // 0x16 (8.8)
+#define VL53L0X_RESULT_OFFSET_SIGNAL_RATE            6   // 0x1A (9.7 MCPS)
+#define VL53L0X_RESULT_OFFSET_AMBIENT_RATE           8   // 0x1C (9.7 MCPS)
+#define VL53L0X_RESULT_OFFSET_RANGE                  10  // 0x1E (mm)
+
+/* Valores para VL53L0X_REG_SYSRANGE_START */
+#define VL53L0X_SYSRANGE_MODE_SINGLESHOT             0x01
+#define VL53L0X_SYSRANGE_MODE_BACKTOBACK             0x02
+#define VL53L0X_SYSRANGE_MODE_TIMED                  0x04
+
+/* Valores para VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG_GPIO */
+#define VL53L0X_GPIO_FUNC_OFF                        0x00
+#define VL53L0X_GPIO_FUNC_THRESHOLD_LOW              0x01   // Distância < THRESH_LOW
+#define VL53L0X_GPIO_FUNC_THRESHOLD_HIGH             0x02   // Distância > THRESH_HIGH
+#define VL53L0X_GPIO_FUNC_THRESHOLD_OUT              0x03   // Fora de [THRESH_LOW, THRESH_HIGH]
+#define VL53L0X_GPIO_FUNC_NEW_SAMPLE_READY           0x04
+
+/* Limiares de distância: registradores de 12 bits em unidades de 2mm */
+#define VL53L0X_THRESHOLD_MAX_MM                     8190
+
+/* Modo de medição ativo */
+typedef enum {
+    VL53L0X_MODE_SINGLE = 0,     // Uma medição por chamada de leitura
+    VL53L0X_MODE_CONTINUOUS,     // Medições back-to-back
+    VL53L0X_MODE_TIMED           // Medições espaçadas pelo período intermedição
+} VL53L0X_RangingMode;
+
+/* Condição que aciona GPIO1 */
+typedef enum {
+    VL53L0X_THRESHOLD_OFF = 0,   // Toda amostra (data-ready)
+    VL53L0X_THRESHOLD_BELOW,     // Distância < low
+    VL53L0X_THRESHOLD_ABOVE,     // Distância > high
+    VL53L0X_THRESHOLD_OUTSIDE,   // Distância < low ou > high
+    VL53L0X_THRESHOLD_INSIDE     // low <= distância < high (limite inferior em software)
+} VL53L0X_ThresholdMode;
+
+/* Etapa da sequência cujo período de VCSEL é configurado */
+typedef enum {
+    VL53L0X_VCSEL_PERIOD_PRE_RANGE = 0,
+    VL53L0X_VCSEL_PERIOD_FINAL_RANGE
+} VL53L0X_VcselPeriodType;
+
+/* Perfis de medição pré-definidos */
+typedef enum {
+    VL53L0X_PROFILE_HIGH_ACCURACY = 0,   // "precisao": objetos estáticos
+    VL53L0X_PROFILE_BALANCED,            // "balanceada": default
+    VL53L0X_PROFILE_FAST,                // "rapida": objetos em movimento
+    VL53L0X_PROFILE_HIGH_SPEED,          // "veloz": budget mínimo, ~50Hz
+    VL53L0X_PROFILE_LONG_RANGE,          // "longo": alcance máximo, pulsos longos
+    VL53L0X_PROFILE_COUNT
+} VL53L0X_ProfileId;
+
+/* Perfil de medição: compromisso taxa x precisão, trocável em tempo de execução */
+typedef struct {
+    const char *name;                    // Nome usado no console
+    uint32_t timingBudgetUs;             // Timing budget (µs)
+    uint32_t periodMs;                   // Período em modo temporizado (ms, >= budget)
+    uint8_t preRangeVcselPeriod;         // PCLKs (12 a 18)
+    uint8_t finalRangeVcselPeriod;       // PCLKs (8 a 14)
+    VL53L0X_FixPt97 signalRateLimit;     // MCPS (9.7)
+    uint16_t sigmaLimit;                 // mm
+    uint8_t validReadsBeforeUpdate;      // Leituras válidas antes de atualizar
+    uint16_t maxMeasurementJump;         // mm - Máxima variação entre medidas
+} VL53L0X_Profile;
+
+/* Budget adaptativo: mantém a sigma média perto do alvo com o menor budget */
+#define VL53L0X_ADAPTIVE_MAX_STEP            4       // Fator máximo de mudança do budget por decisão
+#define VL53L0X_ADAPTIVE_WEAK_SIGMA_FACTOR   2       // Amostra sem sinal conta como sigma = fator * alvo
+
+/* Configuração do budget adaptativo */
+typedef struct {
+    uint16_t targetSigma;                // mm - Sigma média a manter
+    uint32_t minBudgetUs;                // Budget mínimo (>= VL53L0X_MIN_TIMING_BUDGET)
+    uint32_t maxBudgetUs;                // Budget máximo (<= VL53L0X_MAX_TIMING_BUDGET)
+    uint8_t hysteresisPct;               // Banda morta abaixo do alvo (% do alvo, < 100)
+    uint8_t windowSamples;               // Amostras por decisão (>= 1)
+} VL53L0X_AdaptiveBudget;
+
+/* Dados de calibração do sensor (SPADs de referência, VHV/fase e offset) */
+typedef struct {
+    uint8_t spadCount;           // Número de SPADs de referência
+    uint8_t spadTypeIsAperture;  // 1 = SPADs de abertura
+    uint8_t refSpadMap[6];       // Mapa de SPADs de referência habilitados
+    uint8_t vhvSettings;         // Resultado da calibração VHV
+    uint8_t phaseCal;            // Resultado da calibração de fase
+    uint16_t offset;             // ALGO_PART_TO_PART_RANGE_OFFSET_MM (bruto)
+} VL53L0X_Calibration;
 
 /* Function Status Returns */
 typedef enum {
@@ -45,37 +222,424 @@ typedef enum {
     VL53L0X_ERROR = 1
 } VL53L0X_Status;
 
+/* Estado de uma medição em andamento */
+typedef enum {
+    VL53L0X_MEAS_IDLE = 0,       // Nenhuma medição pendente
+    VL53L0X_MEAS_BUSY,           // Medição em andamento, dentro do prazo
+    VL53L0X_MEAS_READY,          // Resultado disponível para VL53L0X_FetchMeasurement
+    VL53L0X_MEAS_TIMEOUT         // Prazo expirou sem sinal de GPIO1
+} VL53L0X_MeasState;
+
+/* Leitura assíncrona do bloco de resultado (i2c_bus) */
+typedef enum {
+    VL53L0X_FETCH_IDLE = 0,      // Nenhuma leitura em andamento
+    VL53L0X_FETCH_BUSY,          // Bloco sendo lido pelo DMA
+    VL53L0X_FETCH_DONE,          // Bloco em resultBlock
+    VL53L0X_FETCH_FAILED         // Transferência falhou
+} VL53L0X_FetchState;
+
+/* Handle de um sensor: barramento, endereço, filtro e configuração em cache */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;             // Barramento I2C do sensor
+    uint8_t address;                     // Endereço I2C de 7 bits
+    
+    /* Filtro de VL53L0X_ReadDistance / VL53L0X_FilterMeasurement */
+    RangeFilter filter;                  // Default: gate com os limites do perfil
+    VL53L0X_RangingData lastRangingData; // Última amostra que gerou saída
+    
+    /* Configuração em cache */
+    const VL53L0X_Profile *profile;      // Perfil ativo (limites de validação)
+    uint8_t stopVariable;                // Lida no init, restaurada a cada start
+    uint32_t timingBudgetUs;             // Timing budget programado (µs)
+    VL53L0X_Calibration calibration;     // Calibração aplicada
+    uint32_t sigmaVcselDuration_us;      // Tempo de VCSEL ligado por medição (estimativa de sigma)
+    VL53L0X_FixPt1616 sigmaRef;          // Termo de referência da sigma para o budget atual
+    
+    /* Cópia dos registradores de configuração (write-through) */
+    uint8_t shadow[VL53L0X_SHADOW_SIZE];
+    uint8_t shadowValid[(VL53L0X_SHADOW_SIZE + 7) / 8];  // Bit por registrador com valor conhecido
+    uint16_t page;                       // Página selecionada em 0xFF (0x100 = desconhecida)
+    uint8_t privateAccess;               // Acessos privados abertos (0x80, 0x00 da página 1)
+    
+    /* Estado da medição */
+    VL53L0X_RangingMode mode;
+    volatile bool dataReady;             // Sinalizado pela EXTI de GPIO1
+    volatile uint32_t dataReadyTick;     // Instante (HAL tick) da borda de GPIO1
+    bool measurementPending;
+    uint32_t measurementStartTick;
+    uint32_t measurementTimeout;         // Margem além do budget/período (ms)
+    uint32_t measurementPeriodMs;        // Período em modo temporizado
+    volatile VL53L0X_FetchState fetchState;  // Atualizado pela conclusão do DMA
+    uint8_t resultBlock[VL53L0X_RESULT_BLOCK_SIZE];  // Destino do DMA
+    
+    /* Status das medições */
+    uint8_t statusPolicy[VL53L0X_RANGE_STATUS_COUNT];    // VL53L0X_StatusPolicy por status
+    uint32_t statusCount[VL53L0X_RANGE_STATUS_COUNT];    // Amostras por status
+    uint32_t retryCount;                 // Medições repetidas pela política
+    bool retryPending;                   // Próxima amostra é uma repetição
+    
+    /* Budget adaptativo */
+    bool adaptiveEnabled;
+    VL53L0X_AdaptiveBudget adaptive;     // Limites e alvo
+    uint32_t adaptiveSigmaSum;           // Soma das sigmas da janela atual (mm)
+    uint8_t adaptiveSamples;             // Amostras na janela atual
+    uint32_t adaptiveChanges;            // Budgets reprogramados
+    
+    /* Janela de limiar de GPIO1 */
+    VL53L0X_ThresholdMode thresholdMode;
+    uint16_t thresholdLowMm;
+    uint16_t thresholdHighMm;
+} VL53L0X_Dev;
+
 /* Function Prototypes */
 
+/**
+ * @brief Prepare a device handle before any other call
+ * @note Does not access the bus; the sensor keeps its current state. The
+ *       register shadow starts empty and fills as registers are read or
+ *       written: known configuration values are then read from RAM and
+ *       writes of an unchanged value are skipped
+ * @param dev Pointer to device handle
+ * @param hi2c Pointer to I2C handle the sensor is attached to
+ * @param address 7-bit I2C address of the sensor
+ */
+void VL53L0X_DevInit(VL53L0X_Dev *dev, I2C_HandleTypeDef *hi2c, uint8_t address);
+
+/**
+ * @brief Change the I2C address of the sensor
+ * @note The new address is volatile: it is lost on XSHUT or power cycle
+ * @param dev Pointer to device handle (address is updated on success)
+ * @param new_address New 7-bit I2C address
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_SetAddress(VL53L0X_Dev *dev, uint8_t new_address);
+
 /**
  * @brief Initialize the VL53L0X sensor
- * @param hi2c Pointer to I2C handle
+ * @note Runs data init, static init (tuning settings, reference SPAD
+ *       management) and VHV/phase reference calibration
+ * @param dev Pointer to device handle
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_Init(VL53L0X_Dev *dev);
+
+/**
+ * @brief Initialize the VL53L0X sensor from a stored calibration
+ * @note Skips the SPAD NVM read and VHV/phase calibration, restoring the
+ *       values in calib instead
+ * @param dev Pointer to device handle
+ * @param calib Calibration captured by VL53L0X_GetCalibration
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_InitFromCalibration(VL53L0X_Dev *dev, const VL53L0X_Calibration *calib);
+
+/**
+ * @brief Get the calibration currently applied to the sensor
+ * @note Valid after a successful VL53L0X_Init or VL53L0X_InitFromCalibration
+ * @param dev Pointer to device handle
+ * @param calib Pointer to store calibration data
+ */
+void VL53L0X_GetCalibration(VL53L0X_Dev *dev, VL53L0X_Calibration *calib);
+
+/**
+ * @brief Get a predefined measurement profile
+ * @param id Profile identifier
+ * @return Pointer to the profile, or NULL if id is out of range
+ */
+const VL53L0X_Profile *VL53L0X_GetProfile(VL53L0X_ProfileId id);
+
+/**
+ * @brief Look up a predefined measurement profile by its console name
+ * @param name Profile name (e.g. "balanceada")
+ * @return Pointer to the profile, or NULL if no profile matches
+ */
+const VL53L0X_Profile *VL53L0X_FindProfile(const char *name);
+
+/**
+ * @brief Apply a measurement profile
+ * @note Programs signal rate limit, VCSEL periods and timing budget, and
+ *       switches the validation limits used by VL53L0X_ReadDistance. The
+ *       filter chain is kept: its gate stages take the profile jump and
+ *       consecutive-read limits, and every stage is reset.
+ *       Ranging must be stopped; restart it with profile->periodMs
+ * @param dev Pointer to device handle
+ * @param profile Profile to apply
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_SetProfile(VL53L0X_Dev *dev, const VL53L0X_Profile *profile);
+
+/**
+ * @brief Get the profile currently applied
+ * @param dev Pointer to device handle
+ * @return Pointer to the active profile
+ */
+const VL53L0X_Profile *VL53L0X_GetActiveProfile(VL53L0X_Dev *dev);
+
+/**
+ * @brief Set the VCSEL pulse period of a sequence step
+ * @note Reprograms the step timeouts, restores the timing budget and redoes
+ *       the phase calibration, as required after a period change
+ * @param dev Pointer to device handle
+ * @param type Pre-range or final-range
+ * @param period_pclks Even period in PCLKs (pre-range 12-18, final-range 8-14)
  * @return VL53L0X_Status
  */
-VL53L0X_Status VL53L0X_Init(I2C_HandleTypeDef *hi2c);
+VL53L0X_Status VL53L0X_SetVcselPulsePeriod(VL53L0X_Dev *dev, VL53L0X_VcselPeriodType type, uint8_t period_pclks);
+
+/**
+ * @brief Program the measurement timing budget
+ * @note Recomputes the final-range timeout from the enabled sequence steps
+ * @param dev Pointer to device handle
+ * @param budget_us Timing budget in microseconds (VL53L0X_MIN_TIMING_BUDGET to
+ *        VL53L0X_MAX_TIMING_BUDGET)
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_SetMeasurementTimingBudget(VL53L0X_Dev *dev, uint32_t budget_us);
+
+/**
+ * @brief Get the measurement timing budget currently programmed
+ * @param dev Pointer to device handle
+ * @return Timing budget in microseconds
+ */
+uint32_t VL53L0X_GetMeasurementTimingBudget(VL53L0X_Dev *dev);
 
 /**
- * @brief Configure sensor for high accuracy mode
- * @param hi2c Pointer to I2C handle
+ * @brief Set the minimum return signal rate for a valid measurement
+ * @param dev Pointer to device handle
+ * @param limit_mcps Limit in MCPS, 9.7 fixed point (use VL53L0X_FP97(mcps))
  * @return VL53L0X_Status
  */
-VL53L0X_Status VL53L0X_SetHighAccuracy(I2C_HandleTypeDef *hi2c);
+VL53L0X_Status VL53L0X_SetSignalRateLimit(VL53L0X_Dev *dev, VL53L0X_FixPt97 limit_mcps);
 
 /**
- * @brief Read distance measurement from sensor with filtering
- * @param hi2c Pointer to I2C handle
+ * @brief Start continuous ranging
+ * @note period_ms = 0 selects back-to-back mode, otherwise timed mode with
+ *       period_ms between measurement starts (must be >= timing budget)
+ * @param dev Pointer to device handle
+ * @param period_ms Inter-measurement period in ms (0 = back-to-back)
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_StartContinuous(VL53L0X_Dev *dev, uint32_t period_ms);
+
+/**
+ * @brief Stop continuous ranging and return to single-shot mode
+ * @param dev Pointer to device handle
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_StopContinuous(VL53L0X_Dev *dev);
+
+/**
+ * @brief Get the currently active ranging mode
+ * @param dev Pointer to device handle
+ * @return VL53L0X_RangingMode
+ */
+VL53L0X_RangingMode VL53L0X_GetRangingMode(VL53L0X_Dev *dev);
+
+/**
+ * @brief Notify the driver that GPIO1 signalled a new sample
+ * @note Called from HAL_GPIO_EXTI_Callback (interrupt context)
+ * @param dev Pointer to device handle
+ */
+void VL53L0X_DataReadyCallback(VL53L0X_Dev *dev);
+
+/**
+ * @brief Check if a new sample is waiting to be collected
+ * @note Reads only the flag set by the EXTI line, no I2C traffic
+ * @param dev Pointer to device handle
+ * @return true if a sample is ready
+ */
+bool VL53L0X_IsDataReady(VL53L0X_Dev *dev);
+
+/**
+ * @brief Set the deadline margin used by VL53L0X_PollMeasurement
+ * @note The deadline is the timing budget (or timed-mode period, if longer)
+ *       plus this margin
+ * @param dev Pointer to device handle
+ * @param timeout_ticks HAL ticks (ms) allowed beyond the expected duration
+ */
+void VL53L0X_SetMeasurementTimeout(VL53L0X_Dev *dev, uint32_t timeout_ticks);
+
+/**
+ * @brief Start a measurement without waiting for it
+ * @note Triggers a single-shot measurement in single-shot mode; in continuous
+ *       or timed mode only re-arms the deadline for the next sample
+ * @param dev Pointer to device handle
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_StartMeasurement(VL53L0X_Dev *dev);
+
+/**
+ * @brief Check progress of the pending measurement
+ * @note TIMEOUT is reported once and clears the pending state. When GPIO1
+ *       has signalled, queues the result block readout at high priority on
+ *       the asynchronous transport (i2c_bus) and reports BUSY until the block
+ *       is in RAM; if
+ *       the handle has no asynchronous transport, reports READY at once and
+ *       VL53L0X_FetchMeasurement reads the block itself
+ * @param dev Pointer to device handle
+ * @return VL53L0X_MeasState
+ */
+VL53L0X_MeasState VL53L0X_PollMeasurement(VL53L0X_Dev *dev);
+
+/**
+ * @brief Collect the result of a completed measurement
+ * @note Call only after VL53L0X_PollMeasurement returned READY; decodes the
+ *       block already read by DMA, if any. Also fills
+ *       the sigma estimate (fixed point, no extra I2C traffic), decodes the
+ *       range status against the profile limits, counts it, applies its
+ *       policy (flag or immediate retry) and feeds the adaptive budget
+ * @param dev Pointer to device handle
  * @param ranging_data Pointer to store ranging data
  * @return VL53L0X_Status
  */
-VL53L0X_Status VL53L0X_ReadRangingData(I2C_HandleTypeDef *hi2c, VL53L0X_RangingData *ranging_data);
+VL53L0X_Status VL53L0X_FetchMeasurement(VL53L0X_Dev *dev, VL53L0X_RangingData *ranging_data);
+
+/**
+ * @brief Make GPIO1 signal only samples matching a distance window
+ * @note The sensor keeps ranging and raises GPIO1 for every sample that meets
+ *       the condition, so the MCU can sleep until then. INSIDE has no
+ *       hardware mode: the sensor filters on high_mm and the lower bound is
+ *       checked by VL53L0X_TakeThresholdEvent. VL53L0X_THRESHOLD_OFF returns
+ *       to data-ready on every sample. PollMeasurement never times out while
+ *       a threshold mode is active
+ * @param dev Pointer to device handle
+ * @param mode Window condition
+ * @param low_mm Lower bound (BELOW, OUTSIDE, INSIDE), resolution 2mm
+ * @param high_mm Upper bound (ABOVE, OUTSIDE, INSIDE), resolution 2mm
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_SetThresholdWindow(VL53L0X_Dev *dev, VL53L0X_ThresholdMode mode, uint16_t low_mm, uint16_t high_mm);
+
+/**
+ * @brief Get the active threshold mode
+ * @param dev Pointer to device handle
+ * @return VL53L0X_ThresholdMode
+ */
+VL53L0X_ThresholdMode VL53L0X_GetThresholdMode(VL53L0X_Dev *dev);
+
+/**
+ * @brief Consume a pending threshold event
+ * @note Only acknowledges the interrupt (one register write), without reading
+ *       the result block; INSIDE also reads the 2-byte range
+ * @param dev Pointer to device handle
+ * @param event Set to true if the latest signalled sample met the condition
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_TakeThresholdEvent(VL53L0X_Dev *dev, bool *event);
+
+/**
+ * @brief Read distance measurement from sensor (blocking, bounded by the timeout)
+ * @note In single-shot mode a measurement is triggered; in continuous or
+ *       timed mode the latest result is collected without a new trigger.
+ *       Returns VL53L0X_ERROR at once while a threshold mode is armed, since
+ *       GPIO1 may never signal and no deadline applies in that mode
+ * @param dev Pointer to device handle
+ * @param ranging_data Pointer to store ranging data
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_ReadRangingData(VL53L0X_Dev *dev, VL53L0X_RangingData *ranging_data);
+
+/**
+ * @brief Set how samples with a given status are handled
+ * @note Defaults: sigma fail accepted flagged, phase fail retried, the
+ *       others dropped. A retry restarts the measurement right after the
+ *       failed sample (single-shot or timed mode) and is never chained: a
+ *       retried sample that fails again is dropped. In timed mode the
+ *       restart shifts the sensor phase by the time left in the period
+ * @param dev Pointer to device handle
+ * @param status Range status (VL53L0X_RANGE_VALID is always accepted)
+ * @param policy Handling policy
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_SetStatusPolicy(VL53L0X_Dev *dev, VL53L0X_RangeStatus status, VL53L0X_StatusPolicy policy);
+
+/**
+ * @brief Get the policy of a range status
+ * @param dev Pointer to device handle
+ * @param status Range status
+ * @return VL53L0X_StatusPolicy
+ */
+VL53L0X_StatusPolicy VL53L0X_GetStatusPolicy(VL53L0X_Dev *dev, VL53L0X_RangeStatus status);
+
+/**
+ * @brief Get the number of samples fetched with a given status
+ * @param dev Pointer to device handle
+ * @param status Range status
+ * @return Sample count since init or the last reset
+ */
+uint32_t VL53L0X_GetStatusCount(VL53L0X_Dev *dev, VL53L0X_RangeStatus status);
+
+/**
+ * @brief Clear the per-status and retry counters
+ * @param dev Pointer to device handle
+ */
+void VL53L0X_ResetStatusCounts(VL53L0X_Dev *dev);
+
+/**
+ * @brief Get a short name for a range status
+ * @param status Range status
+ * @return Name ("valido", "sigma", ...), "?" if out of range
+ */
+const char *VL53L0X_GetRangeStatusName(VL53L0X_RangeStatus status);
+
+/**
+ * @brief Enable or disable the adaptive timing budget
+ * @note Every windowSamples samples VL53L0X_FetchMeasurement compares the
+ *       mean sigma with the target. Above the target or below the dead band
+ *       (targetSigma * (100 - hysteresisPct) / 100) the budget is rescaled,
+ *       assuming sigma ~ 1 / sqrt(budget), to bring the mean sigma to the
+ *       middle of the band; inside the band it is kept. Samples without a
+ *       usable return count as VL53L0X_ADAPTIVE_WEAK_SIGMA_FACTOR * target,
+ *       so a weak return lengthens the budget. Each decision changes the
+ *       budget by at most VL53L0X_ADAPTIVE_MAX_STEP, rounded up to 1ms.
+ *       In timed mode the period follows the budget (same margin as before),
+ *       which drops the phase shift of a staggered array. SetProfile
+ *       restarts from the profile budget. NULL disables and keeps the
+ *       current budget
+ * @param dev Pointer to device handle
+ * @param config Limits and target, or NULL
+ * @return VL53L0X_ERROR if the configuration is invalid (budget limits
+ *         outside VL53L0X_MIN_TIMING_BUDGET..VL53L0X_MAX_TIMING_BUDGET)
+ */
+VL53L0X_Status VL53L0X_SetAdaptiveBudget(VL53L0X_Dev *dev, const VL53L0X_AdaptiveBudget *config);
+
+/**
+ * @brief Get the adaptive timing budget configuration
+ * @param dev Pointer to device handle
+ * @return Pointer to the configuration, or NULL if disabled
+ */
+const VL53L0X_AdaptiveBudget *VL53L0X_GetAdaptiveBudget(VL53L0X_Dev *dev);
+
+/**
+ * @brief Get the filter chain behind VL53L0X_FilterMeasurement
+ * @note Starts as a single gate stage with the profile limits; rebuild it
+ *       with RangeFilter_Init and RangeFilter_Add*
+ * @param dev Pointer to device handle
+ * @return Pointer to the chain
+ */
+RangeFilter *VL53L0X_GetFilter(VL53L0X_Dev *dev);
+
+/**
+ * @brief Validate a sample and run it through the filter chain
+ * @note Samples whose status is not valid are rejected before the chain
+ *       unless their policy accepts them flagged
+ * @param dev Pointer to device handle
+ * @param ranging_data Sample from VL53L0X_FetchMeasurement
+ * @param distance Filtered distance, written only when the function returns true
+ * @return true if the chain produced a new output
+ */
+bool VL53L0X_FilterMeasurement(VL53L0X_Dev *dev, const VL53L0X_RangingData *ranging_data, uint16_t *distance);
 
 /**
  * @brief Read filtered distance measurement from sensor
- * @param hi2c Pointer to I2C handle
+ * @note Blocking wrapper of VL53L0X_ReadRangingData + VL53L0X_FilterMeasurement;
+ *       distance is left unchanged while the chain holds its output. Fails
+ *       while a threshold mode is armed, as VL53L0X_ReadRangingData
+ * @param dev Pointer to device handle
  * @param distance Pointer to store distance value (in mm), can be volatile
  * @return VL53L0X_Status
  */
-VL53L0X_Status VL53L0X_ReadDistance(I2C_HandleTypeDef *hi2c, volatile uint16_t *distance);
+VL53L0X_Status VL53L0X_ReadDistance(VL53L0X_Dev *dev, volatile uint16_t *distance);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,44 @@
+#ifndef VL53L0X_CALIB_H
+#define VL53L0X_CALIB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vl53l0x.h"
+
+/* Página de flash reservada para a calibração (última página de 1 KB, ver linker script) */
+#define VL53L0X_CALIB_FLASH_ADDR   0x0800FC00U
+#define VL53L0X_CALIB_MAGIC        0x564C4342U  // "VLCB"
+#define VL53L0X_CALIB_VERSION      1
+#define VL53L0X_CALIB_SLOTS        4            // Um registro por sensor, em sequência na página
+
+/**
+ * @brief Load the calibration snapshot stored in flash
+ * @param slot Record index (sensor position, < VL53L0X_CALIB_SLOTS)
+ * @param calib Pointer to store calibration data
+ * @return true if a snapshot with valid magic, version and CRC was found
+ */
+bool VL53L0X_Calib_Load(uint8_t slot, VL53L0X_Calibration *calib);
+
+/**
+ * @brief Store a calibration snapshot in flash
+ * @note Erases the reserved page before programming; the other slots are
+ *       preserved
+ * @param slot Record index (sensor position, < VL53L0X_CALIB_SLOTS)
+ * @param calib Calibration data to store
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_Calib_Save(uint8_t slot, const VL53L0X_Calibration *calib);
+
+/**
+ * @brief Invalidate all stored snapshots, forcing calibration on next boot
+ * @return VL53L0X_Status
+ */
+VL53L0X_Status VL53L0X_Calib_Erase(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VL53L0X_CALIB_H */
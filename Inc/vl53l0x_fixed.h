@@ -0,0 +1,92 @@
+#ifndef VL53L0X_FIXED_H
+#define VL53L0X_FIXED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Aritmética em ponto fixo do driver. O Cortex-M3 (-mfloat-abi=soft) emula
+   float em software, então nenhum cálculo por amostra usa float. */
+
+typedef uint16_t VL53L0X_FixPt97;        // 9.7: taxas de sinal/ambiente dos registradores (MCPS)
+typedef uint32_t VL53L0X_FixPt1616;      // 16.16: formato intermediário da API da ST (MCPS, mm)
+
+/* Constantes a partir de literais, resolvidas em tempo de compilação */
+#define VL53L0X_FP97(mcps)               ((VL53L0X_FixPt97)((mcps) * 128.0 + 0.5))
+#define VL53L0X_FP1616(value)            ((VL53L0X_FixPt1616)((value) * 65536.0 + 0.5))
+#define VL53L0X_FP97_MAX                 0xFFFF  // 511.99 MCPS
+
+/* Relógio do sensor: macro período = 2304 períodos de VCSEL de 1.655ns por PCLK */
+#define VL53L0X_PLL_PERIOD_PS            1655
+#define VL53L0X_MACRO_PERIOD_VCLKS       2304
+
+/* 9.7 -> 16.16 (exato) */
+static inline VL53L0X_FixPt1616 VL53L0X_FP97To1616(VL53L0X_FixPt97 value)
+{
+    return (VL53L0X_FixPt1616)value << 9;
+}
+
+/* 16.16 -> inteiro, arredondado e saturado (ex.: sigma em mm). Satura antes
+   de somar o meio LSB, que estouraria 32 bits perto de UINT32_MAX */
+static inline uint16_t VL53L0X_FP1616ToInt(VL53L0X_FixPt1616 value)
+{
+    if(value >= 0xFFFF8000U) {
+        return 0xFFFF;
+    }
+    
+    return (uint16_t)((uint32_t)(value + 0x8000U) >> 16);
+}
+
+/* Raiz quadrada inteira (bit a bit, sem divisão) */
+static inline uint32_t VL53L0X_ISqrt(uint32_t num)
+{
+    uint32_t res = 0;
+    uint32_t bit = 1UL << 30;
+    
+    while(bit > num) {
+        bit >>= 2;
+    }
+    
+    while(bit != 0) {
+        if(num >= res + bit) {
+            num -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    
+    return res;
+}
+
+/* Macro período em ns para um período de VCSEL em PCLKs */
+static inline uint32_t VL53L0X_CalcMacroPeriod(uint8_t vcsel_period_pclks)
+{
+    return ((uint32_t)VL53L0X_MACRO_PERIOD_VCLKS * vcsel_period_pclks * VL53L0X_PLL_PERIOD_PS + 500) / 1000;
+}
+
+/* MCLKs -> µs. Separa a parte inteira do macro período em µs para não
+   estourar 32 bits com timeouts longos e VCSEL de 18 PCLKs */
+static inline uint32_t VL53L0X_TimeoutMclksToMicroseconds(uint32_t timeout_mclks, uint8_t vcsel_period_pclks)
+{
+    uint32_t macro_period_ns = VL53L0X_CalcMacroPeriod(vcsel_period_pclks);
+    
+    return timeout_mclks * (macro_period_ns / 1000) + (timeout_mclks * (macro_period_ns % 1000) + 500) / 1000;
+}
+
+/* µs -> MCLKs, arredondado (timeout_us < 4.29s) */
+static inline uint32_t VL53L0X_TimeoutMicrosecondsToMclks(uint32_t timeout_us, uint8_t vcsel_period_pclks)
+{
+    uint32_t macro_period_ns = VL53L0X_CalcMacroPeriod(vcsel_period_pclks);
+    
+    return (timeout_us * 1000 + (macro_period_ns / 2)) / macro_period_ns;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VL53L0X_FIXED_H */
@@ -0,0 +1,655 @@
+#include "i2c_bus.h"
+#include <string.h>
+
+/* Posição da fila: descritor e cópia dos dados de escrita */
+typedef struct {
+    I2CBus_Transaction transaction;
+    uint8_t buffer[I2C_BUS_TX_BUFFER_SIZE];
+    uint32_t sequence;                   // Ordem de chegada
+    bool used;                           // Reservada (pendente ou em andamento)
+    bool pending;                        // Aguardando a vez
+} I2CBus_Slot;
+
+static I2C_HandleTypeDef *bus_hi2c = NULL;
+static I2CBus_Slot queue[I2C_BUS_QUEUE_SIZE];
+static I2CBus_Slot *volatile active = NULL;
+static volatile uint8_t queued = 0;
+static volatile bool suspended = false;
+static uint32_t next_sequence = 0;
+static volatile uint32_t active_tick = 0;
+static volatile bool sync_done = false;
+static volatile HAL_StatusTypeDef sync_status = HAL_OK;
+static I2CBus_Stats bus_stats;
+static volatile uint8_t consecutive_errors = 0;
+static bool fallback_enabled = true;
+static uint32_t error_tick = 0;
+
+/* Private function prototypes */
+static bool I2CBus_Owns(I2C_HandleTypeDef *hi2c);
+static uint32_t I2CBus_Lock(void);
+static void I2CBus_Unlock(uint32_t primask);
+static void I2CBus_StartNext(void);
+static HAL_StatusTypeDef I2CBus_Start(I2CBus_Slot *slot);
+static void I2CBus_Finish(HAL_StatusTypeDef status);
+static void I2CBus_Release(I2CBus_Slot *slot, HAL_StatusTypeDef status);
+static void I2CBus_Flush(HAL_StatusTypeDef status);
+static bool I2CBus_Stalled(uint32_t timeout_ms);
+static HAL_StatusTypeDef I2CBus_Transfer(I2C_HandleTypeDef *hi2c, I2CBus_Op op, I2CBus_Priority priority,
+                                         uint8_t address, uint8_t reg, uint8_t *data, uint16_t count);
+static void I2CBus_SyncComplete(void *context, HAL_StatusTypeDef status);
+static void I2CBus_Account(I2C_HandleTypeDef *hi2c, HAL_StatusTypeDef status);
+static void I2CBus_CheckFallback(I2C_HandleTypeDef *hi2c);
+static bool I2CBus_LinesStuck(I2C_HandleTypeDef *hi2c);
+static void I2CBus_CheckHealth(I2C_HandleTypeDef *hi2c);
+static void I2CBus_DelayHalfBit(void);
+
+void I2CBus_Init(I2C_HandleTypeDef *hi2c)
+{
+    bus_hi2c = hi2c;
+    memset(queue, 0, sizeof(queue));
+    active = NULL;
+    queued = 0;
+    suspended = false;
+    next_sequence = 0;
+    memset(&bus_stats, 0, sizeof(bus_stats));
+    consecutive_errors = 0;
+    fallback_enabled = true;
+}
+
+bool I2CBus_IsBusy(I2C_HandleTypeDef *hi2c)
+{
+    return I2CBus_Owns(hi2c) && queued > 0;
+}
+
+HAL_StatusTypeDef I2CBus_WaitIdle(I2C_HandleTypeDef *hi2c, uint32_t timeout_ms)
+{
+    while(I2CBus_IsBusy(hi2c)) {
+        if(I2CBus_Stalled(timeout_ms)) {
+            /* Transferência presa: libera as linhas e reinicia o periférico */
+            I2CBus_Recover(hi2c);
+            return HAL_TIMEOUT;
+        }
+        I2CBus_StartNext();
+    }
+    
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef I2CBus_Submit(I2C_HandleTypeDef *hi2c, const I2CBus_Transaction *transaction)
+{
+    I2CBus_Slot *slot = NULL;
+    uint32_t primask;
+    
+    if(!I2CBus_Owns(hi2c) || transaction->op > I2C_BUS_OP_PROBE || transaction->priority >= I2C_BUS_PRIORITY_COUNT) {
+        return HAL_ERROR;
+    }
+    if(transaction->op != I2C_BUS_OP_PROBE && (transaction->data == NULL || transaction->count == 0)) {
+        return HAL_ERROR;
+    }
+    if(transaction->op == I2C_BUS_OP_WRITE && transaction->count > I2C_BUS_TX_BUFFER_SIZE) {
+        return HAL_ERROR;
+    }
+    
+    primask = I2CBus_Lock();
+    for(uint8_t i = 0; i < I2C_BUS_QUEUE_SIZE; i++) {
+        if(!queue[i].used) {
+            slot = &queue[i];
+            slot->used = true;
+            queued++;
+            break;
+        }
+    }
+    I2CBus_Unlock(primask);
+    
+    if(slot == NULL) {
+        return HAL_BUSY;
+    }
+    
+    /* A escrita vai copiada, o chamador pode reutilizar os dados; a sonda
+       recebe o byte na própria posição */
+    memcpy(&slot->transaction, transaction, sizeof(I2CBus_Transaction));
+    if(transaction->op == I2C_BUS_OP_WRITE) {
+        memcpy(slot->buffer, transaction->data, transaction->count);
+        slot->transaction.data = slot->buffer;
+    } else if(transaction->op == I2C_BUS_OP_PROBE) {
+        slot->transaction.data = slot->buffer;
+        slot->transaction.count = 1;
+    }
+    
+    primask = I2CBus_Lock();
+    slot->sequence = next_sequence++;
+    slot->pending = true;
+    I2CBus_Unlock(primask);
+    
+    I2CBus_StartNext();
+    
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef I2CBus_ReadAsync(I2C_HandleTypeDef *hi2c, I2CBus_Priority priority, uint8_t address, uint8_t reg,
+                                   uint8_t *data, uint16_t count, I2CBus_Callback callback, void *context)
+{
+    I2CBus_Transaction transaction;
+    
+    transaction.op = I2C_BUS_OP_READ;
+    transaction.priority = priority;
+    transaction.address = address;
+    transaction.reg = reg;
+    transaction.data = data;
+    transaction.count = count;
+    transaction.callback = callback;
+    transaction.context = context;
+    
+    return I2CBus_Submit(hi2c, &transaction);
+}
+
+HAL_StatusTypeDef I2CBus_WriteAsync(I2C_HandleTypeDef *hi2c, I2CBus_Priority priority, uint8_t address, uint8_t reg,
+                                    const uint8_t *data, uint16_t count, I2CBus_Callback callback, void *context)
+{
+    I2CBus_Transaction transaction;
+    
+    transaction.op = I2C_BUS_OP_WRITE;
+    transaction.priority = priority;
+    transaction.address = address;
+    transaction.reg = reg;
+    transaction.data = (uint8_t *)data;
+    transaction.count = count;
+    transaction.callback = callback;
+    transaction.context = context;
+    
+    return I2CBus_Submit(hi2c, &transaction);
+}
+
+HAL_StatusTypeDef I2CBus_Read(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t count)
+{
+    if(!I2CBus_Owns(hi2c)) {
+        return HAL_I2C_Mem_Read(hi2c, address << 1, reg, I2C_MEMADD_SIZE_8BIT, data, count, I2C_BUS_TIMEOUT);
+    }
+    
+    return I2CBus_Transfer(hi2c, I2C_BUS_OP_READ, I2C_BUS_PRIORITY_NORMAL, address, reg, data, count);
+}
+
+HAL_StatusTypeDef I2CBus_Write(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, const uint8_t *data, uint16_t count)
+{
+    if(!I2CBus_Owns(hi2c)) {
+        return HAL_I2C_Mem_Write(hi2c, address << 1, reg, I2C_MEMADD_SIZE_8BIT, (uint8_t *)data, count, I2C_BUS_TIMEOUT);
+    }
+    
+    return I2CBus_Transfer(hi2c, I2C_BUS_OP_WRITE, I2C_BUS_PRIORITY_NORMAL, address, reg, (uint8_t *)data, count);
+}
+
+HAL_StatusTypeDef I2CBus_Probe(I2C_HandleTypeDef *hi2c, uint8_t address)
+{
+    if(!I2CBus_Owns(hi2c)) {
+        return HAL_I2C_IsDeviceReady(hi2c, address << 1, 2, 5);
+    }
+    
+    return I2CBus_Transfer(hi2c, I2C_BUS_OP_PROBE, I2C_BUS_PRIORITY_LOW, address, 0, NULL, 0);
+}
+
+void I2CBus_Process(I2C_HandleTypeDef *hi2c)
+{
+    if(!I2CBus_Owns(hi2c)) {
+        return;
+    }
+    
+    if(I2CBus_Stalled(I2C_BUS_TIMEOUT)) {
+        I2CBus_Recover(hi2c);
+        return;
+    }
+    
+    /* A fila só anda fora de interrupção */
+    I2CBus_StartNext();
+}
+
+HAL_StatusTypeDef I2CBus_Recover(I2C_HandleTypeDef *hi2c)
+{
+    GPIO_InitTypeDef gpio = {0};
+    uint32_t hung_tick = (consecutive_errors > 0) ? error_tick : HAL_GetTick();
+    bool was_suspended = suspended;
+    bool released;
+    
+    if(hi2c != bus_hi2c) {
+        return HAL_ERROR;
+    }
+    
+    /* Fila parada durante a recuperação; a transferência em andamento, se
+       houver, é perdida */
+    suspended = true;
+    I2CBus_Finish(HAL_TIMEOUT);
+    HAL_I2C_DeInit(hi2c);
+    
+    /* SCL e SDA como GPIO open-drain, soltos */
+    HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+    HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_SET);
+    gpio.Mode = GPIO_MODE_OUTPUT_OD;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+    gpio.Pin = I2C_BUS_SCL_PIN;
+    HAL_GPIO_Init(I2C_BUS_SCL_PORT, &gpio);
+    gpio.Pin = I2C_BUS_SDA_PIN;
+    HAL_GPIO_Init(I2C_BUS_SDA_PORT, &gpio);
+    I2CBus_DelayHalfBit();
+    
+    /* Escravo segurando SDA no meio de um byte: cada pulso avança um bit */
+    for(uint8_t i = 0; i < I2C_BUS_RECOVERY_PULSES &&
+                       HAL_GPIO_ReadPin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN) == GPIO_PIN_RESET; i++) {
+        HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_RESET);
+        I2CBus_DelayHalfBit();
+        HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+        I2CBus_DelayHalfBit();
+    }
+    
+    /* STOP: SDA sobe com SCL alto, encerrando a transação para todos os escravos */
+    HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_RESET);
+    I2CBus_DelayHalfBit();
+    HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_RESET);
+    I2CBus_DelayHalfBit();
+    HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+    I2CBus_DelayHalfBit();
+    HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_SET);
+    I2CBus_DelayHalfBit();
+    released = (HAL_GPIO_ReadPin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN) == GPIO_PIN_SET &&
+                HAL_GPIO_ReadPin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN) == GPIO_PIN_SET);
+    
+    /* MspInit devolve os pinos ao I2C (com DMA e NVIC); o SWRST do
+       HAL_I2C_Init limpa o BUSY travado */
+    HAL_I2C_Init(hi2c);
+    consecutive_errors = 0;
+    
+    if(!released || I2CBus_LinesStuck(hi2c)) {
+        /* Sem barramento as transações pendentes não teriam fim: quem
+           espera por elas recebe o erro */
+        bus_stats.recoveryFailures++;
+        I2CBus_Flush(HAL_ERROR);
+        suspended = was_suspended;
+        return HAL_ERROR;
+    }
+    
+    bus_stats.recoveries++;
+    bus_stats.lastRecoveryMs = HAL_GetTick() - hung_tick;
+    if(bus_stats.lastRecoveryMs > bus_stats.maxRecoveryMs) {
+        bus_stats.maxRecoveryMs = bus_stats.lastRecoveryMs;
+    }
+    
+    suspended = was_suspended;
+    if(!was_suspended) {
+        I2CBus_StartNext();
+    }
+    
+    return HAL_OK;
+}
+HAL_StatusTypeDef I2CBus_SetSpeed(I2C_HandleTypeDef *hi2c, uint32_t clock_hz, uint32_t duty_cycle)
+{
+    HAL_StatusTypeDef status;
+    
+    if(clock_hz == 0 || clock_hz > I2C_BUS_SPEED_FAST) {
+        return HAL_ERROR;
+    }
+    if(duty_cycle != I2C_DUTYCYCLE_2 && duty_cycle != I2C_DUTYCYCLE_16_9) {
+        return HAL_ERROR;
+    }
+    if(I2CBus_WaitIdle(hi2c, I2C_BUS_TIMEOUT) != HAL_OK) {
+        return HAL_TIMEOUT;
+    }
+    
+    /* HAL_I2C_Init com o handle já inicializado só reprograma o periférico (sem MSP) */
+    suspended = true;
+    hi2c->Init.ClockSpeed = clock_hz;
+    hi2c->Init.DutyCycle = duty_cycle;
+    consecutive_errors = 0;
+    status = HAL_I2C_Init(hi2c);
+    suspended = false;
+    
+    return status;
+}
+
+void I2CBus_SetFallback(I2C_HandleTypeDef *hi2c, bool enable)
+{
+    if(hi2c == bus_hi2c) {
+        fallback_enabled = enable;
+        consecutive_errors = 0;
+    }
+}
+
+void I2CBus_GetStats(I2C_HandleTypeDef *hi2c, I2CBus_Stats *stats)
+{
+    if(hi2c == bus_hi2c) {
+        memcpy(stats, &bus_stats, sizeof(I2CBus_Stats));
+    } else {
+        memset(stats, 0, sizeof(I2CBus_Stats));
+    }
+}
+
+/* Conclusão das transferências (chamados pela HAL no contexto de interrupção).
+   A próxima transação não parte daqui: ver I2CBus_StartNext */
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c == bus_hi2c) {
+        I2CBus_Finish(HAL_OK);
+    }
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c == bus_hi2c) {
+        I2CBus_Finish(HAL_OK);
+    }
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c == bus_hi2c) {
+        I2CBus_Finish(HAL_OK);
+    }
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c == bus_hi2c) {
+        I2CBus_Finish(HAL_ERROR);
+    }
+}
+
+void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c == bus_hi2c) {
+        I2CBus_Finish(HAL_ERROR);
+    }
+}
+
+/* Private Functions */
+
+/* Só o handle registrado, com os dois canais de DMA ligados, é assíncrono */
+static bool I2CBus_Owns(I2C_HandleTypeDef *hi2c)
+{
+    return (hi2c == bus_hi2c && hi2c->hdmarx != NULL && hi2c->hdmatx != NULL);
+}
+
+/* Seção crítica aninhável: a fila é alterada pelo loop e pelas interrupções */
+static uint32_t I2CBus_Lock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    
+    __disable_irq();
+    
+    return primask;
+}
+
+static void I2CBus_Unlock(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+/* Inicia a transação pendente de maior prioridade (a mais antiga entre as de
+   mesma prioridade) se o barramento estiver livre, verificando antes
+   travamento e fallback com a fila parada. Só fora de interrupção: no F1 o
+   START e o endereço (I2C_RequestMemoryRead/Write) são esperados em laço com
+   prazo por HAL_GetTick, que não avança dentro das interrupções de I2C/DMA
+   (prioridade 0, acima do SysTick); um barramento travado prenderia o MCU ali */
+static void I2CBus_StartNext(void)
+{
+    if(__get_IPSR() != 0U) {
+        return;
+    }
+    
+    for(;;) {
+        I2CBus_Slot *slot = NULL;
+        uint32_t primask = I2CBus_Lock();
+    
+        if(active != NULL || suspended || queued == 0) {
+            I2CBus_Unlock(primask);
+            return;
+        }
+    
+        suspended = true;
+        I2CBus_Unlock(primask);
+        I2CBus_CheckHealth(bus_hi2c);
+        I2CBus_CheckFallback(bus_hi2c);
+        primask = I2CBus_Lock();
+        suspended = false;
+    
+        for(uint8_t i = 0; i < I2C_BUS_QUEUE_SIZE; i++) {
+            if(!queue[i].pending) {
+                continue;
+            }
+            if(slot == NULL || queue[i].transaction.priority < slot->transaction.priority ||
+               (queue[i].transaction.priority == slot->transaction.priority &&
+                (int32_t)(queue[i].sequence - slot->sequence) < 0)) {
+                slot = &queue[i];
+            }
+        }
+        if(slot != NULL && active == NULL) {
+            slot->pending = false;
+            active = slot;
+            active_tick = HAL_GetTick();
+        } else {
+            slot = NULL;
+        }
+        I2CBus_Unlock(primask);
+    
+        if(slot == NULL || I2CBus_Start(slot) == HAL_OK) {
+            return;
+        }
+    
+        /* Não iniciou (HAL ocupada): conclui com erro e tenta a próxima */
+        I2CBus_Finish(HAL_ERROR);
+    }
+}
+
+/* Programa a transferência da posição no periférico */
+static HAL_StatusTypeDef I2CBus_Start(I2CBus_Slot *slot)
+{
+    I2CBus_Transaction *transaction = &slot->transaction;
+    uint16_t address = (uint16_t)transaction->address << 1;
+    
+    switch(transaction->op) {
+        case I2C_BUS_OP_READ:
+            /* Recepção de 1 ou 2 bytes com DMA não é confiável no F1: a HAL em modo
+               interrupção segue a sequência de ACK/POS/STOP do manual */
+            if(transaction->count < I2C_BUS_DMA_MIN_RX) {
+                return HAL_I2C_Mem_Read_IT(bus_hi2c, address, transaction->reg, I2C_MEMADD_SIZE_8BIT,
+                                           transaction->data, transaction->count);
+            }
+            return HAL_I2C_Mem_Read_DMA(bus_hi2c, address, transaction->reg, I2C_MEMADD_SIZE_8BIT,
+                                        transaction->data, transaction->count);
+        case I2C_BUS_OP_WRITE:
+            if(transaction->count < I2C_BUS_DMA_MIN_TX) {
+                return HAL_I2C_Mem_Write_IT(bus_hi2c, address, transaction->reg, I2C_MEMADD_SIZE_8BIT,
+                                            transaction->data, transaction->count);
+            }
+            return HAL_I2C_Mem_Write_DMA(bus_hi2c, address, transaction->reg, I2C_MEMADD_SIZE_8BIT,
+                                         transaction->data, transaction->count);
+        default:
+            /* Leitura de 1 byte sem índice: nenhum registrador é alterado */
+            return HAL_I2C_Master_Receive_IT(bus_hi2c, address, transaction->data, 1);
+    }
+}
+
+/* Encerra a transferência em andamento; a primeira notificação vence
+   (interrupção e recuperação podem concluir a mesma) */
+static void I2CBus_Finish(HAL_StatusTypeDef status)
+{
+    uint32_t primask = I2CBus_Lock();
+    I2CBus_Slot *slot = active;
+    
+    active = NULL;
+    I2CBus_Unlock(primask);
+    
+    if(slot == NULL) {
+        return;
+    }
+    
+    /* Sonda sem ACK só indica endereço vazio, não conta como erro */
+    if(slot->transaction.op != I2C_BUS_OP_PROBE || status == HAL_OK ||
+       !(bus_hi2c->ErrorCode & HAL_I2C_ERROR_AF)) {
+        I2CBus_Account(bus_hi2c, status);
+    }
+    I2CBus_Release(slot, status);
+}
+
+/* Libera a posição antes de notificar: o callback pode enfileirar outra transação */
+static void I2CBus_Release(I2CBus_Slot *slot, HAL_StatusTypeDef status)
+{
+    I2CBus_Callback callback = slot->transaction.callback;
+    void *context = slot->transaction.context;
+    uint32_t primask = I2CBus_Lock();
+    
+    slot->used = false;
+    queued--;
+    I2CBus_Unlock(primask);
+    
+    if(callback != NULL) {
+        callback(context, status);
+    }
+}
+
+/* Descarta as transações pendentes */
+static void I2CBus_Flush(HAL_StatusTypeDef status)
+{
+    for(uint8_t i = 0; i < I2C_BUS_QUEUE_SIZE; i++) {
+        uint32_t primask = I2CBus_Lock();
+        bool pending = queue[i].pending;
+    
+        queue[i].pending = false;
+        I2CBus_Unlock(primask);
+    
+        if(pending) {
+            I2CBus_Release(&queue[i], status);
+        }
+    }
+}
+
+/* Transferência em andamento há timeout_ms ou mais */
+static bool I2CBus_Stalled(uint32_t timeout_ms)
+{
+    uint32_t primask = I2CBus_Lock();
+    bool stalled = (active != NULL && HAL_GetTick() - active_tick >= timeout_ms);
+    
+    I2CBus_Unlock(primask);
+    
+    return stalled;
+}
+
+/* Enfileira e espera a conclusão, mantendo a fila andando (só fora de interrupção) */
+static HAL_StatusTypeDef I2CBus_Transfer(I2C_HandleTypeDef *hi2c, I2CBus_Op op, I2CBus_Priority priority,
+                                         uint8_t address, uint8_t reg, uint8_t *data, uint16_t count)
+{
+    I2CBus_Transaction transaction;
+    HAL_StatusTypeDef status;
+    
+    transaction.op = op;
+    transaction.priority = priority;
+    transaction.address = address;
+    transaction.reg = reg;
+    transaction.data = data;
+    transaction.count = count;
+    transaction.callback = I2CBus_SyncComplete;
+    transaction.context = NULL;
+    sync_done = false;
+    
+    /* Fila cheia: aguarda uma posição */
+    while((status = I2CBus_Submit(hi2c, &transaction)) == HAL_BUSY) {
+        I2CBus_Process(hi2c);
+    }
+    if(status != HAL_OK) {
+        return status;
+    }
+    
+    while(!sync_done) {
+        I2CBus_Process(hi2c);
+    }
+    
+    return sync_status;
+}
+
+/* Conclusão das chamadas bloqueantes */
+static void I2CBus_SyncComplete(void *context, HAL_StatusTypeDef status)
+{
+    (void)context;
+    sync_status = status;
+    sync_done = true;
+}
+/* Conta o resultado de uma transferência pelo código de erro da HAL */
+static void I2CBus_Account(I2C_HandleTypeDef *hi2c, HAL_StatusTypeDef status)
+{
+    if(hi2c != bus_hi2c) {
+        return;
+    }
+    
+    if(status == HAL_OK) {
+        bus_stats.transfers++;
+        consecutive_errors = 0;
+        return;
+    }
+    
+    /* Início da sequência de erros: base do tempo de recuperação */
+    if(consecutive_errors == 0) {
+        error_tick = HAL_GetTick();
+    }
+    
+    if(hi2c->ErrorCode & HAL_I2C_ERROR_AF) {
+        bus_stats.nackErrors++;
+    } else if(hi2c->ErrorCode & HAL_I2C_ERROR_ARLO) {
+        bus_stats.arloErrors++;
+    } else if(hi2c->ErrorCode & HAL_I2C_ERROR_BERR) {
+        bus_stats.busErrors++;
+    } else {
+        bus_stats.timeouts++;
+    }
+    if(consecutive_errors < UINT8_MAX) {
+        consecutive_errors++;
+    }
+}
+
+/* Erros seguidos em fast mode (cabo longo, pull-up fraco): volta ao standard
+   mode antes da próxima transferência. Só fora de interrupção */
+static void I2CBus_CheckFallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c != bus_hi2c || !fallback_enabled || consecutive_errors < I2C_BUS_FALLBACK_ERRORS) {
+        return;
+    }
+    consecutive_errors = 0;
+    if(hi2c->Init.ClockSpeed <= I2C_BUS_SPEED_STANDARD) {
+        return;
+    }
+    
+    hi2c->Init.ClockSpeed = I2C_BUS_SPEED_STANDARD;
+    hi2c->Init.DutyCycle = I2C_DUTYCYCLE_2;
+    HAL_I2C_Init(hi2c);
+    bus_stats.fallbacks++;
+}
+
+/* BUSY ativo ou SDA baixo: alguém segura o barramento */
+static bool I2CBus_LinesStuck(I2C_HandleTypeDef *hi2c)
+{
+    return (__HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_BUSY) != RESET ||
+            HAL_GPIO_ReadPin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN) == GPIO_PIN_RESET);
+}
+
+/* Barramento ocioso que continua ocupado por I2C_BUS_HUNG_MS (escravo travado
+   no meio de um byte ou BUSY travado do F1) é recuperado. Só fora de interrupção */
+static void I2CBus_CheckHealth(I2C_HandleTypeDef *hi2c)
+{
+    uint32_t start_tick = HAL_GetTick();
+    
+    if(hi2c != bus_hi2c || active != NULL) {
+        return;
+    }
+    
+    /* Um STOP recém-emitido ainda pode estar em curso */
+    while(I2CBus_LinesStuck(hi2c)) {
+        if(HAL_GetTick() - start_tick >= I2C_BUS_HUNG_MS) {
+            I2CBus_Recover(hi2c);
+            return;
+        }
+    }
+}
+
+/* ~5 us, meio período de SCL a 100 kHz (o laço gasta alguns ciclos por volta) */
+static void I2CBus_DelayHalfBit(void)
+{
+    for(volatile uint32_t n = SystemCoreClock / 1000000 * 5 / 4; n > 0; n--) {
+    }
+}
@@ -18,6 +18,7 @@
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "dma.h"
 #include "i2c.h"
 #include "usart.h"
 #include "gpio.h"
@@ -25,10 +26,15 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "vl53l0x.h"
+#include "vl53l0x_calib.h"
+#include "i2c_bus.h"
+#include "range_array.h"
+#include "range_sched.h"
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -38,6 +44,35 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define DEFAULT_PROFILE         VL53L0X_PROFILE_BALANCED    // 200ms, 5Hz
+#define PROXIMITY_DISTANCE_MM   100     // mm - Objeto "próximo" (LED e modo prox)
+#define PROXIMITY_RELEASE_MARGIN_MS 50  // ms - Folga além do período antes de declarar livre
+#define DEFAULT_FILTER          "gate"  // Cadeia de filtros no boot (política original)
+#define FILTER_EMA_ALPHA        64      // Q8 - Ganho da EMA (0.25)
+#define FILTER_EMA_SIGMA_REF_MM 20      // mm - Sigma em que o ganho da EMA cai à metade
+#define FILTER_HAMPEL_K         30      // Décimos - Limiar do Hampel (3.0 MAD)
+#define FILTER_BENCH_SAMPLES    64      // Amostras sintéticas por cadeia no benchmark
+#define FILTER_BENCH_SPIKE_AT   16      // Amostra com um pico espúrio de 2000mm
+#define FILTER_BENCH_STEP_AT    32      // Amostra do degrau 300mm -> 600mm
+#define ADAPTIVE_MIN_BUDGET_MS  20      // ms - Limites default do budget adaptativo
+#define ADAPTIVE_MAX_BUDGET_MS  500
+#define ADAPTIVE_HYSTERESIS_PCT 30      // % - Banda morta abaixo da sigma alvo
+#define ADAPTIVE_WINDOW         5       // Amostras por decisão
+#define SCHED_ACTIVE_PROFILE    VL53L0X_PROFILE_HIGH_SPEED  // Perfil com movimento na cena
+#define SCHED_IDLE_PERIOD_MS    1000    // ms - Período com a cena parada (mínimo: período do perfil)
+#define SCHED_THRESHOLD_MM      30      // mm - Variação da distância filtrada que indica movimento
+#define SCHED_ATTACK_MS         0       // ms - Movimento sustentado antes de acelerar
+#define SCHED_DECAY_MS          3000    // ms - Cena parada antes de voltar ao período lento
+#define I2C_TEST_DURATION_MS    250     // ms - Rajada de leituras por velocidade no teste do barramento
+#define I2C_SCAN_FIRST_ADDRESS  0x01    // Faixa sondada pelo i2c_bar (endereços 7-bit válidos)
+#define I2C_SCAN_LAST_ADDRESS   0x77
+#define I2C_SCAN_PROBES_PER_LOOP 2      // Sondas por volta do loop (deixa a fila livre para as leituras)
+
+/* Com a cena parada o rastreador não pode ver o período lento (mais o jitter
+   da leitura) como uma lacuna, ou a velocidade zeraria a cada amostra */
+#if SCHED_IDLE_PERIOD_MS * 2 > RANGE_TRACKER_MAX_GAP_MS
+#error "SCHED_IDLE_PERIOD_MS muito próximo de RANGE_TRACKER_MAX_GAP_MS"
+#endif
 
 /* USER CODE END PD */
 
@@ -52,12 +87,37 @@
 /* Variaveis globais */
 static uint16_t current_distance_mm = 0;
 static bool sensor_initialized_ok = false;
-static uint8_t rx_buffer[16];
+static uint8_t led_sensor_index = 0;      // Sensor que ritma o LED
+static const VL53L0X_Profile *active_profile = NULL;
+static uint8_t rx_buffer[32];
 static bool command_received = false;
-static uint32_t uwTick_last_measurement = 0;
 static uint32_t init_start_time = 0;
 static bool init_blink_period = true;
 
+/* Modo de proximidade: GPIO1 só sinaliza amostras dentro da janela */
+static VL53L0X_ThresholdMode proximity_mode = VL53L0X_THRESHOLD_OFF;
+static uint16_t proximity_low_mm = 0;
+static uint16_t proximity_high_mm = 0;
+static uint32_t proximity_event_tick = 0;   // Último evento de qualquer sensor
+static bool proximity_detected = false;
+
+/* Cadeia de filtros aplicada a todos os sensores */
+static char filter_spec[32] = DEFAULT_FILTER;
+
+/* Agendamento por movimento: período lento parado, perfil rápido com movimento */
+static RangeSched sched;
+static bool sched_enabled = false;
+
+/* Recuperações de barramento já tratadas pelo loop */
+static uint32_t bus_recoveries = 0;
+
+/* Varredura incremental do I2C: sondas na fila do barramento, tabela no fim */
+static volatile uint8_t scan_found[16];     // Bitmap dos endereços que responderam (última varredura)
+static volatile uint8_t scan_pending = 0;   // Sondas na fila do I2C
+static uint8_t scan_next_address = 0;
+static bool scan_active = false;
+static uint32_t scan_start_tick = 0;
+
 /* Flag para controle da recepção UART */
 volatile uint8_t uart_rx_complete = 0;
 /* USER CODE END PV */
@@ -65,8 +125,29 @@ volatile uint8_t uart_rx_complete = 0;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
-static void I2C_Scan_Bus(void);
+static void I2C_Scan_Start(void);
+static void I2C_Scan_Process(void);
+static void I2C_Scan_ProbeDone(void *context, HAL_StatusTypeDef status);
+static void I2C_Scan_Print(void);
+static void I2C_Speed_Command(const char *arg);
+static void I2C_Speed_Test(void);
+static void Bus_Process(void);
 static void Start_Uart_Reception(void);
+static VL53L0X_Status Sensor_Setup(uint8_t index, bool force_calibration);
+static bool Sensors_Setup(bool force_calibration);
+static void Sensor_Prefix(char *prefix, uint8_t index);
+static bool Sensors_Restart(const VL53L0X_Profile *profile, uint32_t period_ms);
+static void Profile_Command(const char *arg);
+static void Proximity_Command(const char *arg);
+static void Proximity_Process(void);
+static bool Filter_Build(RangeFilter *filter, const char *spec);
+static void Filter_Command(const char *arg);
+static void Filter_Benchmark(void);
+static void Status_Command(const char *arg);
+static void Budget_Command(const char *arg);
+static uint32_t Sched_IdlePeriod(void);
+static void Sched_Apply(void);
+static void Sched_Command(const char *arg);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -103,6 +184,7 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_I2C1_Init();
   MX_USART1_UART_Init();
   /* USER CODE BEGIN 2 */
@@ -110,25 +192,17 @@ int main(void)
   /* Garante que o LED começa apagado */
   HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_SET); // LED é ativo baixo
   
-  /* Tenta inicializar o sensor VL53L0X */
-  VL53L0X_Status init_status = VL53L0X_Init(&hi2c1);
-  sensor_initialized_ok = (init_status == VL53L0X_OK);
+  /* Leitura dos resultados e rajadas de configuração por DMA */
+  I2CBus_Init(&hi2c1);
   
-  /* Log do status de inicialização */
-  char init_msg[64];
-  sprintf(init_msg, "Status inicializacao: %s (code: %d)\r\n", 
-          sensor_initialized_ok ? "OK" : "ERRO", init_status);
-  HAL_UART_Transmit(&huart1, (uint8_t*)init_msg, strlen(init_msg), 100);
+  /* Liga os sensores um a um pelo XSHUT e atribui um endereço a cada */
+  RangeArray_Init(&hi2c1);
   
-  /* Configura modo de alta precisão se inicialização OK */
-  if(sensor_initialized_ok) {
-      VL53L0X_Status accuracy_status = VL53L0X_SetHighAccuracy(&hi2c1);
-      if(accuracy_status != VL53L0X_OK) {
-          sensor_initialized_ok = false;
-          sprintf(init_msg, "Erro ao configurar alta precisao (code: %d)\r\n", accuracy_status);
-          HAL_UART_Transmit(&huart1, (uint8_t*)init_msg, strlen(init_msg), 100);
-      }
-  }
+  /* Inicializa os sensores (calibração restaurada da flash quando válida) */
+  active_profile = VL53L0X_GetProfile(DEFAULT_PROFILE);
+  RangeSched_Config sched_config = { SCHED_THRESHOLD_MM, SCHED_ATTACK_MS, SCHED_DECAY_MS };
+  RangeSched_Init(&sched, &sched_config);
+  sensor_initialized_ok = Sensors_Setup(false);
   
   /* Inicia contagem do período de 10s se sensor foi inicializado */
   if(sensor_initialized_ok) {
@@ -138,10 +212,13 @@ int main(void)
 
   /* Envia mensagens de boas-vindas */
   HAL_UART_Transmit(&huart1, (uint8_t*)"bem vindo ao console de informações\r\n", 37, 100);
-  char msg[64];
-  sprintf(msg, "Sensor range finder %s\r\n", sensor_initialized_ok ? "iniciado" : "nao iniciado");
+  char msg[80];
+  sprintf(msg, "Sensor range finder %s (%u sensor(es))\r\n", sensor_initialized_ok ? "iniciado" : "nao iniciado",
+          RangeArray_GetCount());
+  HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+  sprintf(msg, "distancia medida a cada %lu ms (perfil %s) se disponivel.\r\n",
+          (unsigned long)active_profile->periodMs, active_profile->name);
   HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
-  HAL_UART_Transmit(&huart1, (uint8_t*)"distancia medida a 5hz se disponivel.\r\n", 39, 100);
   HAL_UART_Transmit(&huart1, (uint8_t*)"> ", 2, 100);
 
   /* Inicia a recepção UART em modo IT */
@@ -156,53 +233,107 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-    /* Medição de distância a 5Hz (200ms) */
-    if(HAL_GetTick() - uwTick_last_measurement >= 200)
+    /* Medição de distância no período do perfil ativo (5Hz no default), ritmada pelo sensor via GPIO1.
+       Os sensores medem defasados no período; o loop nunca espera por eles,
+       apenas dispara as fases pendentes e consulta o estado de cada medição. */
+    if(sensor_initialized_ok)
+    {
+      RangeArray_Process();
+    }
+    
+    /* Fila do I2C; barramento recuperado pelo i2c_bus religa a medição */
+    Bus_Process();
+    
+    /* Varredura do i2c_bar: poucas sondas por volta, sem parar a medição */
+    I2C_Scan_Process();
+    
+    /* Modo de proximidade: só eventos de limiar, sem leitura por amostra */
+    if(sensor_initialized_ok && proximity_mode != VL53L0X_THRESHOLD_OFF)
+    {
+      Proximity_Process();
+    }
+    
+    bool sched_changed = false;
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS && sensor_initialized_ok &&
+                       proximity_mode == VL53L0X_THRESHOLD_OFF; i++)
     {
-      uwTick_last_measurement = HAL_GetTick();
+      RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+      if(!sensor->online)
+      {
+        continue;
+      }
       
-      if(sensor_initialized_ok)
+      char prefix[8];
+      Sensor_Prefix(prefix, i);
+      VL53L0X_MeasState meas_state = VL53L0X_PollMeasurement(&sensor->dev);
+      
+      if(meas_state == VL53L0X_MEAS_READY)
       {
         /* Lê a distância do sensor */
         VL53L0X_RangingData ranging_data = {0};
-        VL53L0X_Status read_status = VL53L0X_ReadRangingData(&hi2c1, &ranging_data);
-        
+        VL53L0X_Status read_status = VL53L0X_FetchMeasurement(&sensor->dev, &ranging_data);
+      
         if(read_status == VL53L0X_OK)
         {
-          /* Envia os dados detalhados pela UART */
-          char msg[64];
-          sprintf(msg, "Dist: %u mm, Status: %u, Signal: %u\r\n", 
-                  ranging_data.distance_mm,
-                  ranging_data.rangeStatus,
-                  ranging_data.signalRate);
-          HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
-          
-          current_distance_mm = ranging_data.distance_mm;
-          
-          /* Controle do LED baseado na distância e tempo */
-          if(init_blink_period)
+          /* Validação e cadeia de filtros; sem saída mantém a última distância filtrada */
+          uint16_t filtered;
+          if(VL53L0X_FilterMeasurement(&sensor->dev, &ranging_data, &filtered))
           {
-            /* Durante os primeiros 10 segundos, pisca o LED */
-            if(HAL_GetTick() - init_start_time <= 10000)
-            {
-              HAL_GPIO_TogglePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin);
-            }
-            else
+            sensor->lastDistance_mm = filtered;
+            
+            /* Agendamento: movimento acelera, cena parada desacelera */
+            if(sched_enabled && RangeSched_Update(&sched, i, filtered, ranging_data.timestamp))
             {
-              init_blink_period = false;
-              HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_SET); // Apaga LED
+              sched_changed = true;
             }
           }
-          else
+          current_distance_mm = RangeArray_GetNearestDistance();
+        
+          /* Rastreador: velocidade e distância prevista para agora (esconde a latência da amostra) */
+          RangeTracker_Update(&sensor->tracker, &ranging_data);
+        
+          /* Envia os dados detalhados pela UART */
+          char msg[128];
+          sprintf(msg, "%sDist: %u mm, Status: %u%s, Signal: %u, Sigma: %u mm, Filt: %u mm, Vel: %d mm/s, Prev: %u mm\r\n",
+                  prefix,
+                  ranging_data.distance_mm,
+                  ranging_data.rangeStatus,
+                  ranging_data.flagged ? "*" : "",
+                  ranging_data.signalRate,
+                  ranging_data.sigma,
+                  sensor->lastDistance_mm,
+                  RangeTracker_GetVelocity(&sensor->tracker),
+                  RangeTracker_Predict(&sensor->tracker, HAL_GetTick()));
+          HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+        
+          /* Controle do LED baseado na distância e tempo (objeto mais próximo),
+             atualizado no ritmo de um único sensor */
+          if(i == led_sensor_index)
           {
-            /* Após 10s, LED acende apenas se objeto próximo */
-            if(current_distance_mm < 100)
+            if(init_blink_period)
             {
-              HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_RESET); // Acende LED
+              /* Durante os primeiros 10 segundos, pisca o LED */
+              if(HAL_GetTick() - init_start_time <= 10000)
+              {
+                HAL_GPIO_TogglePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin);
+              }
+              else
+              {
+                init_blink_period = false;
+                HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_SET); // Apaga LED
+              }
             }
             else
             {
-              HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_SET); // Apaga LED
+              /* Após 10s, LED acende apenas se objeto próximo */
+              if(current_distance_mm < PROXIMITY_DISTANCE_MM)
+              {
+                HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_RESET); // Acende LED
+              }
+              else
+              {
+                HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_SET); // Apaga LED
+              }
             }
           }
         }
@@ -212,6 +343,20 @@ int main(void)
           HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_SET);
         }
       }
+      else if(meas_state == VL53L0X_MEAS_TIMEOUT)
+      {
+        /* Sensor não concluiu a medição no prazo: apaga o LED e rearma */
+        HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_SET);
+        sprintf(msg, "%sTimeout de medicao\r\n", prefix);
+        HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+        VL53L0X_StartMeasurement(&sensor->dev);
+      }
+    }
+    
+    /* Troca de taxa após a varredura: reinicia todos os sensores de uma vez */
+    if(sched_changed)
+    {
+      Sched_Apply();
     }
 
     /* Processamento de comando recebido */
@@ -219,9 +364,59 @@ int main(void)
     {
       if(strcmp((char*)rx_buffer, "i2c_bar") == 0)
       {
-        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nIniciando I2C Bus Scan (i2cdetect-like)...\r\n", 46, 100);
-        I2C_Scan_Bus();
-        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\n> ", 4, 100);
+        /* Varredura em segundo plano: a tabela sai quando todas as sondas concluírem */
+        I2C_Scan_Start();
+      }
+      else if(strncmp((char*)rx_buffer, "i2c_vel", 7) == 0)
+      {
+        /* Velocidade do I2C1: mostra, troca ou testa cada uma */
+        I2C_Speed_Command((char*)rx_buffer + 7);
+        HAL_UART_Transmit(&huart1, (uint8_t*)"> ", 2, 100);
+      }
+      else if(strcmp((char*)rx_buffer, "recal") == 0)
+      {
+        /* Recalibra o sensor e regrava a calibração na flash */
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nRecalibrando sensor...\r\n", 26, 100);
+        RangeArray_StopAll();
+        proximity_mode = VL53L0X_THRESHOLD_OFF;
+        sensor_initialized_ok = Sensors_Setup(true);
+        HAL_UART_Transmit(&huart1, (uint8_t*)"> ", 2, 100);
+      }
+      else if(strncmp((char*)rx_buffer, "perfil", 6) == 0)
+      {
+        /* Lista os perfis ou troca o perfil ativo sem reinicializar */
+        Profile_Command((char*)rx_buffer + 6);
+        HAL_UART_Transmit(&huart1, (uint8_t*)"> ", 2, 100);
+      }
+      else if(strncmp((char*)rx_buffer, "filtro", 6) == 0)
+      {
+        /* Mostra, troca ou mede a cadeia de filtros de distância */
+        Filter_Command((char*)rx_buffer + 6);
+        HAL_UART_Transmit(&huart1, (uint8_t*)"> ", 2, 100);
+      }
+      else if(strncmp((char*)rx_buffer, "status", 6) == 0)
+      {
+        /* Contadores e política de cada status de medição */
+        Status_Command((char*)rx_buffer + 6);
+        HAL_UART_Transmit(&huart1, (uint8_t*)"> ", 2, 100);
+      }
+      else if(strncmp((char*)rx_buffer, "budget", 6) == 0)
+      {
+        /* Budget fixo do perfil ou adaptativo pela sigma */
+        Budget_Command((char*)rx_buffer + 6);
+        HAL_UART_Transmit(&huart1, (uint8_t*)"> ", 2, 100);
+      }
+      else if(strncmp((char*)rx_buffer, "agenda", 6) == 0)
+      {
+        /* Agendamento por movimento: período lento parado, perfil rápido com movimento */
+        Sched_Command((char*)rx_buffer + 6);
+        HAL_UART_Transmit(&huart1, (uint8_t*)"> ", 2, 100);
+      }
+      else if(strncmp((char*)rx_buffer, "prox", 4) == 0)
+      {
+        /* Liga/desliga o modo de proximidade por interrupção de limiar */
+        Proximity_Command((char*)rx_buffer + 4);
+        HAL_UART_Transmit(&huart1, (uint8_t*)"> ", 2, 100);
       }
       
       /* Limpa buffer e flag */
@@ -231,6 +426,12 @@ int main(void)
       /* Reinicia recepção UART */
       Start_Uart_Reception();
     }
+    
+    /* Em proximidade o MCU dorme até o próximo evento: GPIO1 (EXTI), UART ou SysTick */
+    if(proximity_mode != VL53L0X_THRESHOLD_OFF && !command_received)
+    {
+      __WFI();
+    }
   }
   /* USER CODE END 3 */
 }
@@ -276,45 +477,1222 @@ void SystemClock_Config(void)
 
 /* USER CODE BEGIN 4 */
 /**
-  * @brief I2C Bus Scanner function
-  * @note Scans all valid I2C addresses (0x01-0x7F) and prints results
+  * @brief Initialize and start every VL53L0X sensor online
+  * @note Sensors are configured one after the other, then started in timed
+  *       mode phase-shifted over the active profile period by RangeArray_Process
+  * @param force_calibration Ignore the stored snapshots
+  * @retval true if at least one sensor is online and all of them initialized
+  */
+static bool Sensors_Setup(bool force_calibration)
+{
+    bool all_ok = (RangeArray_GetCount() > 0);
+    bool led_sensor_found = false;
+    
+    if(!all_ok)
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"Nenhum sensor encontrado\r\n", 26, 100);
+        return false;
+    }
+    
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+    {
+        if(!RangeArray_GetSensor(i)->online)
+        {
+            continue;
+        }
+        
+        /* O primeiro sensor online ritma o LED */
+        if(!led_sensor_found)
+        {
+            led_sensor_index = i;
+            led_sensor_found = true;
+        }
+        
+        if(Sensor_Setup(i, force_calibration) != VL53L0X_OK)
+        {
+            all_ok = false;
+        }
+    }
+    
+    /* Sensores medem sozinhos em modo temporizado; o loop apenas coleta o resultado */
+    if(all_ok)
+    {
+        RangeSched_Reset(&sched);
+        RangeArray_StartStaggered(Sched_IdlePeriod());
+    }
+    
+    return all_ok;
+}
+
+/**
+  * @brief Initialize one VL53L0X sensor of the array
+  * @note Restores the calibration snapshot from flash when valid; otherwise
+  *       (or when forced) runs the full calibration and stores a new snapshot
+  * @param index Sensor slot, also used as the flash calibration slot
+  * @param force_calibration Ignore the stored snapshot
+  * @retval VL53L0X_Status
+  */
+static VL53L0X_Status Sensor_Setup(uint8_t index, bool force_calibration)
+{
+    char msg[80];
+    char prefix[8];
+    VL53L0X_Dev *dev = &RangeArray_GetSensor(index)->dev;
+    VL53L0X_Calibration calib;
+    VL53L0X_Status status = VL53L0X_ERROR;
+    bool calib_restored = false;
+    
+    Sensor_Prefix(prefix, index);
+    
+    /* Boot rápido: pula SPAD e calibração de referência */
+    if(!force_calibration && VL53L0X_Calib_Load(index, &calib))
+    {
+        status = VL53L0X_InitFromCalibration(dev, &calib);
+        calib_restored = (status == VL53L0X_OK);
+    }
+    
+    /* Calibração completa e gravação de um novo snapshot */
+    if(!calib_restored)
+    {
+        status = VL53L0X_Init(dev);
+        if(status == VL53L0X_OK)
+        {
+            VL53L0X_GetCalibration(dev, &calib);
+            if(VL53L0X_Calib_Save(index, &calib) != VL53L0X_OK)
+            {
+                HAL_UART_Transmit(&huart1, (uint8_t*)"Erro ao gravar calibracao\r\n", 27, 100);
+            }
+        }
+    }
+    
+    /* Log do status de inicialização */
+    sprintf(msg, "%sStatus inicializacao: %s (code: %d, calib: %s, addr: 0x%02X)\r\n", prefix,
+            (status == VL53L0X_OK) ? "OK" : "ERRO", status,
+            calib_restored ? "flash" : "nova", dev->address);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    
+    if(status != VL53L0X_OK)
+    {
+        return status;
+    }
+    
+    /* Aplica o perfil de medição ativo */
+    status = VL53L0X_SetProfile(dev, active_profile);
+    if(status != VL53L0X_OK)
+    {
+        sprintf(msg, "%sErro ao aplicar perfil %s (code: %d)\r\n", prefix, active_profile->name, status);
+        HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    }
+    
+    return status;
+}
+
+/**
+  * @brief Build the console prefix identifying a sensor
+  * @note Empty with a single sensor, keeping the single-sensor output format
+  * @param prefix Buffer of at least 8 bytes
+  * @param index Sensor slot
   * @retval None
   */
-static void I2C_Scan_Bus(void)
+static void Sensor_Prefix(char *prefix, uint8_t index)
 {
-    char msg[64];
-    uint8_t i, j;
+    if(RangeArray_GetCount() > 1)
+    {
+        sprintf(prefix, "S%u ", index + 1);
+    }
+    else
+    {
+        prefix[0] = '\0';
+    }
+}
+
+/**
+  * @brief Handle the "perfil [nome]" console command
+  * @note Without a name lists the profiles; otherwise stops ranging, applies
+  *       the profile to every sensor and restarts the staggered schedule
+  * @param arg Text following the command word
+  * @retval None
+  */
+static void Profile_Command(const char *arg)
+{
+    char msg[80];
+    const VL53L0X_Profile *profile;
+    
+    while(*arg == ' ')
+    {
+        arg++;
+    }
+    
+    /* Sem argumento: lista os perfis disponíveis */
+    if(*arg == '\0')
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nPerfis disponiveis:\r\n", 23, 100);
+        for(uint8_t i = 0; i < VL53L0X_PROFILE_COUNT; i++)
+        {
+            profile = VL53L0X_GetProfile((VL53L0X_ProfileId)i);
+            sprintf(msg, "%c %-10s budget %lu us, periodo %lu ms, VCSEL %u/%u\r\n",
+                    (profile == active_profile) ? '*' : ' ', profile->name,
+                    (unsigned long)profile->timingBudgetUs, (unsigned long)profile->periodMs,
+                    profile->preRangeVcselPeriod, profile->finalRangeVcselPeriod);
+            HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+        }
+        return;
+    }
+    
+    profile = VL53L0X_FindProfile(arg);
+    if(profile == NULL)
+    {
+        sprintf(msg, "\r\nPerfil desconhecido: %s\r\n", arg);
+        HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+        return;
+    }
+    
+    active_profile = profile;
+    sprintf(msg, "\r\nAplicando perfil %s...\r\n", profile->name);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    
+    /* Sensores não inicializados recebem o perfil no próximo recal */
+    if(!sensor_initialized_ok)
+    {
+        return;
+    }
+    
+    /* O agendamento recomeça parado, no perfil escolhido */
+    RangeSched_Reset(&sched);
+    Sensors_Restart(profile, Sched_IdlePeriod());
+}
+
+/**
+  * @brief Apply a profile to every sensor online and restart the schedule
+  * @note Stops ranging, applies the profile and restarts the staggered
+  *       timed mode with period_ms; a failure leaves the sensors stopped
+  * @param profile Profile to apply
+  * @param period_ms Timed-mode period (>= profile budget)
+  * @retval true if every sensor accepted the profile
+  */
+static bool Sensors_Restart(const VL53L0X_Profile *profile, uint32_t period_ms)
+{
+    char msg[80];
+    
+    RangeArray_StopAll();
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+    {
+        RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+        if(sensor->online && VL53L0X_SetProfile(&sensor->dev, profile) != VL53L0X_OK)
+        {
+            char prefix[8];
+            Sensor_Prefix(prefix, i);
+            sprintf(msg, "%sErro ao aplicar perfil %s\r\n", prefix, profile->name);
+            HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+            sensor_initialized_ok = false;
+        }
+    }
+    
+    if(sensor_initialized_ok)
+    {
+        RangeArray_StartStaggered(period_ms);
+    }
     
-    HAL_UART_Transmit(&huart1, (uint8_t*)"     0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F\r\n", 49, 100);
+    return sensor_initialized_ok;
+}
+
+/**
+  * @brief Build a filter chain from a console specification
+  * @note Space-separated stages, applied in order: "gate" (jump and
+  *       consecutive limits of the active profile), "medianaN", "hampelN",
+  *       "ema" (sigma weighted) or "nenhum" (pass-through)
+  * @param filter Chain to rebuild
+  * @param spec Stage list
+  * @retval false if a stage is unknown or invalid
+  */
+static bool Filter_Build(RangeFilter *filter, const char *spec)
+{
+    RangeFilter_Init(filter);
     
-    for(i = 0; i < 8; i++)
+    while(*spec != '\0')
     {
-        sprintf(msg, "%02X: ", i * 16);
-        HAL_UART_Transmit(&huart1, (uint8_t*)msg, 4, 100);
+        bool ok;
+        size_t len;
         
-        for(j = 0; j < 16; j++)
+        while(*spec == ' ')
         {
-            uint8_t address = (i * 16) + j;
-            if(address >= 0x01 && address <= 0x77)  // Valid I2C addresses
+            spec++;
+        }
+        len = strcspn(spec, " ");
+        if(len == 0)
+        {
+            break;
+        }
+        
+        if(len == 4 && strncmp(spec, "gate", 4) == 0)
+        {
+            ok = RangeFilter_AddGate(filter, active_profile->maxMeasurementJump, active_profile->validReadsBeforeUpdate);
+        }
+        else if(len == 3 && strncmp(spec, "ema", 3) == 0)
+        {
+            ok = RangeFilter_AddEma(filter, FILTER_EMA_ALPHA, FILTER_EMA_SIGMA_REF_MM);
+        }
+        else if(len == 6 && strncmp(spec, "nenhum", 6) == 0)
+        {
+            ok = true;
+        }
+        else if(len > 7 && strncmp(spec, "mediana", 7) == 0)
+        {
+            ok = RangeFilter_AddMedian(filter, (uint8_t)strtoul(spec + 7, NULL, 10));
+        }
+        else if(len > 6 && strncmp(spec, "hampel", 6) == 0)
+        {
+            ok = RangeFilter_AddHampel(filter, (uint8_t)strtoul(spec + 6, NULL, 10), FILTER_HAMPEL_K);
+        }
+        else
+        {
+            ok = false;
+        }
+        
+        if(!ok)
+        {
+            return false;
+        }
+        spec += len;
+    }
+    
+    return true;
+}
+
+/**
+  * @brief Handle the "filtro [bench|cadeia]" console command
+  * @note Without arguments shows the active chain; "bench" runs the
+  *       benchmark; otherwise the chain is rebuilt on every sensor
+  * @param arg Text following the command word
+  * @retval None
+  */
+static void Filter_Command(const char *arg)
+{
+    static RangeFilter check;
+    char msg[80];
+    
+    while(*arg == ' ')
+    {
+        arg++;
+    }
+    
+    if(*arg == '\0')
+    {
+        sprintf(msg, "\r\nFiltro: %s\r\n", filter_spec);
+        HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+        return;
+    }
+    
+    if(strcmp(arg, "bench") == 0)
+    {
+        Filter_Benchmark();
+        return;
+    }
+    
+    /* Valida antes de alterar os sensores */
+    if(strlen(arg) >= sizeof(filter_spec) || !Filter_Build(&check, arg))
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nUso: filtro [bench|gate mediana3..7 hampel3..7 ema nenhum]\r\n", 62, 100);
+        return;
+    }
+    
+    strcpy(filter_spec, arg);
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+    {
+        RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+        if(sensor->online)
+        {
+            Filter_Build(VL53L0X_GetFilter(&sensor->dev), filter_spec);
+        }
+    }
+    
+    sprintf(msg, "\r\nFiltro: %s\r\n", filter_spec);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+}
+
+/**
+  * @brief Measure every filter chain on a synthetic input
+  * @note Runs a 300mm -> 600mm step with small noise and one 2000mm spike
+  *       through each chain and prints DWT cycles per sample, the step lag
+  *       (samples until the output reaches 95% of the step) and whether the
+  *       spike reached the output. Ranging is not interrupted
+  * @retval None
+  */
+static void Filter_Benchmark(void)
+{
+    static const char *const chains[] = { "nenhum", "gate", "mediana5", "hampel5", "ema", "mediana3 ema", "hampel5 ema" };
+    static const int8_t noise[8] = { 0, 3, -2, 4, -4, 1, -3, 2 };
+    static RangeFilter filter;
+    char msg[80];
+    
+    /* Contador de ciclos do núcleo (DWT) */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    
+    HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nCadeia         ciclos  atraso  pico\r\n", 39, 100);
+    
+    for(uint8_t c = 0; c < sizeof(chains) / sizeof(chains[0]); c++)
+    {
+        uint32_t cycles = 0;
+        int16_t lag = -1;
+        bool spike_passed = false;
+        uint16_t output = 0;
+        
+        Filter_Build(&filter, chains[c]);
+        
+        for(uint16_t k = 0; k < FILTER_BENCH_SAMPLES; k++)
+        {
+            uint16_t input = ((k < FILTER_BENCH_STEP_AT) ? 300 : 600) + noise[k % 8];
+            bool has_output;
+            uint32_t start;
+            
+            if(k == FILTER_BENCH_SPIKE_AT)
             {
-                // Try to communicate with the device
-                if(HAL_I2C_IsDeviceReady(&hi2c1, address << 1, 2, 5) == HAL_OK)
-                {
-                    sprintf(msg, "%02X ", address);
-                }
-                else
+                input = 2000;
+            }
+            
+            start = DWT->CYCCNT;
+            has_output = RangeFilter_Process(&filter, input, 5, &output);
+            cycles += DWT->CYCCNT - start;
+            
+            if(has_output && k < FILTER_BENCH_STEP_AT && output > 450)
+            {
+                spike_passed = true;
+            }
+            if(has_output && k >= FILTER_BENCH_STEP_AT && lag < 0 && output >= 585)
+            {
+                lag = k - FILTER_BENCH_STEP_AT;
+            }
+        }
+        
+        sprintf(msg, "%-14s %6lu  %6d  %s\r\n", chains[c], (unsigned long)(cycles / FILTER_BENCH_SAMPLES),
+                lag, spike_passed ? "passou" : "rejeitado");
+        HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    }
+    
+    sprintf(msg, "Atraso em amostras (x %lu ms no perfil %s)\r\n",
+            (unsigned long)active_profile->periodMs, active_profile->name);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+}
+
+/**
+  * @brief Handle the "status [zerar|<status> <politica>]" console command
+  * @note Without arguments prints the per-status counters of every sensor
+  *       and the policy of each status; "zerar" clears the counters;
+  *       otherwise sets the policy (descartar, marcar, repetir) of a status
+  *       on every sensor
+  * @param arg Text following the command word
+  * @retval None
+  */
+static void Status_Command(const char *arg)
+{
+    static const char *const policy_names[] = { "descartar", "marcar", "repetir" };
+    char msg[80];
+    char *pos;
+    
+    while(*arg == ' ')
+    {
+        arg++;
+    }
+    
+    if(*arg == '\0')
+    {
+        RangeArray_Sensor *first = RangeArray_GetSensor(led_sensor_index);
+        
+        pos = msg + sprintf(msg, "\r\nStatus  Politica ");
+        for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+        {
+            if(RangeArray_GetSensor(i)->online)
+            {
+                pos += sprintf(pos, "        S%u", i + 1);
+            }
+        }
+        strcpy(pos, "\r\n");
+        HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+        
+        /* Uma linha por status; a política é a mesma em todos os sensores */
+        for(uint8_t s = 0; s <= VL53L0X_RANGE_STATUS_COUNT; s++)
+        {
+            if(s < VL53L0X_RANGE_STATUS_COUNT)
+            {
+                pos = msg + sprintf(msg, "%-7s %-9s", VL53L0X_GetRangeStatusName((VL53L0X_RangeStatus)s),
+                                    (s == VL53L0X_RANGE_VALID) ? "-" :
+                                    policy_names[VL53L0X_GetStatusPolicy(&first->dev, (VL53L0X_RangeStatus)s)]);
+            }
+            else
+            {
+                pos = msg + sprintf(msg, "%-17s", "repetidas");
+            }
+            for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+            {
+                RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+                if(sensor->online)
                 {
-                    sprintf(msg, "-- ");
+                    pos += sprintf(pos, " %9lu", (unsigned long)((s < VL53L0X_RANGE_STATUS_COUNT) ?
+                                   VL53L0X_GetStatusCount(&sensor->dev, (VL53L0X_RangeStatus)s) : sensor->dev.retryCount));
                 }
             }
-            else
+            strcpy(pos, "\r\n");
+            HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+        }
+        return;
+    }
+    
+    if(strcmp(arg, "zerar") == 0)
+    {
+        for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+        {
+            if(RangeArray_GetSensor(i)->online)
             {
-                sprintf(msg, "   ");
+                VL53L0X_ResetStatusCounts(&RangeArray_GetSensor(i)->dev);
             }
-            HAL_UART_Transmit(&huart1, (uint8_t*)msg, 3, 100);
         }
-        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\n", 2, 100);
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nContadores zerados\r\n", 22, 100);
+        return;
     }
+    
+    /* "<status> <politica>" */
+    size_t len = strcspn(arg, " ");
+    const char *policy_arg = arg + len;
+    uint8_t s;
+    uint8_t p;
+    
+    while(*policy_arg == ' ')
+    {
+        policy_arg++;
+    }
+    for(s = 1; s < VL53L0X_RANGE_STATUS_COUNT; s++)
+    {
+        const char *name = VL53L0X_GetRangeStatusName((VL53L0X_RangeStatus)s);
+        if(strlen(name) == len && strncmp(arg, name, len) == 0)
+        {
+            break;
+        }
+    }
+    for(p = 0; p < sizeof(policy_names) / sizeof(policy_names[0]); p++)
+    {
+        if(strcmp(policy_arg, policy_names[p]) == 0)
+        {
+            break;
+        }
+    }
+    if(s == VL53L0X_RANGE_STATUS_COUNT || p == sizeof(policy_names) / sizeof(policy_names[0]))
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nUso: status [zerar|sigma|sinal|min|fase|hw|wrap descartar|marcar|repetir]\r\n", 77, 100);
+        return;
+    }
+    
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+    {
+        RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+        if(sensor->online)
+        {
+            VL53L0X_SetStatusPolicy(&sensor->dev, (VL53L0X_RangeStatus)s, (VL53L0X_StatusPolicy)p);
+        }
+    }
+    sprintf(msg, "\r\nStatus %s: %s\r\n", VL53L0X_GetRangeStatusName((VL53L0X_RangeStatus)s), policy_names[p]);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+}
+
+/**
+  * @brief Handle the "budget [fixo | auto <sigma> [min max]]" console command
+  * @note Without arguments shows the budget of each sensor. "auto" holds the
+  *       mean sigma (mm) with the shortest budget between min and max (ms);
+  *       "fixo" disables it and reapplies the active profile
+  * @param arg Text following the command word
+  * @retval None
+  */
+static void Budget_Command(const char *arg)
+{
+    char msg[128];
+    VL53L0X_AdaptiveBudget config;
+    unsigned long sigma_mm = 0;
+    unsigned long min_ms = ADAPTIVE_MIN_BUDGET_MS;
+    unsigned long max_ms = ADAPTIVE_MAX_BUDGET_MS;
+    
+    while(*arg == ' ')
+    {
+        arg++;
+    }
+    
+    if(*arg == '\0')
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\n", 2, 100);
+        for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+        {
+            RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+            const VL53L0X_AdaptiveBudget *adaptive;
+            if(!sensor->online)
+            {
+                continue;
+            }
+            
+            adaptive = VL53L0X_GetAdaptiveBudget(&sensor->dev);
+            if(adaptive != NULL)
+            {
+                sprintf(msg, "S%u budget %lu us, auto sigma %u mm (%lu-%lu ms), %lu ajustes\r\n", i + 1,
+                        (unsigned long)VL53L0X_GetMeasurementTimingBudget(&sensor->dev), adaptive->targetSigma,
+                        (unsigned long)(adaptive->minBudgetUs / 1000), (unsigned long)(adaptive->maxBudgetUs / 1000),
+                        (unsigned long)sensor->dev.adaptiveChanges);
+            }
+            else
+            {
+                sprintf(msg, "S%u budget %lu us, fixo\r\n", i + 1,
+                        (unsigned long)VL53L0X_GetMeasurementTimingBudget(&sensor->dev));
+            }
+            HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+        }
+        return;
+    }
+    
+    if(strcmp(arg, "fixo") == 0)
+    {
+        for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+        {
+            if(RangeArray_GetSensor(i)->online)
+            {
+                VL53L0X_SetAdaptiveBudget(&RangeArray_GetSensor(i)->dev, NULL);
+            }
+        }
+        
+        /* Volta ao budget e ao escalonamento do perfil */
+        Profile_Command(active_profile->name);
+        return;
+    }
+    
+    if(strncmp(arg, "auto", 4) == 0)
+    {
+        int fields = sscanf(arg + 4, "%lu %lu %lu", &sigma_mm, &min_ms, &max_ms);
+        
+        /* Limites em ms checados antes da conversão para µs, que estouraria 32 bits */
+        if((fields != 1 && fields != 3) || max_ms > VL53L0X_MAX_TIMING_BUDGET / 1000)
+        {
+            sigma_mm = 0;
+        }
+    }
+    
+    config.targetSigma = (uint16_t)((sigma_mm > VL53L0X_SIGMA_MAX) ? 0 : sigma_mm);
+    config.minBudgetUs = (uint32_t)min_ms * 1000;
+    config.maxBudgetUs = (uint32_t)max_ms * 1000;
+    config.hysteresisPct = ADAPTIVE_HYSTERESIS_PCT;
+    config.windowSamples = ADAPTIVE_WINDOW;
+    
+    /* Os limites são validados pelo driver, iguais para todos os sensores */
+    bool ok = (config.targetSigma != 0);
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS && ok; i++)
+    {
+        RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+        if(sensor->online && VL53L0X_SetAdaptiveBudget(&sensor->dev, &config) != VL53L0X_OK)
+        {
+            ok = false;
+        }
+    }
+    if(!ok)
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nUso: budget [fixo | auto <sigma mm> [<min ms> <max ms>]]\r\n", 60, 100);
+        return;
+    }
+    
+    sprintf(msg, "\r\nBudget adaptativo: sigma %lu mm, %lu-%lu ms\r\n", sigma_mm, min_ms, max_ms);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+}
+
+/**
+  * @brief Get the timed-mode period while the scene is still
+  * @note SCHED_IDLE_PERIOD_MS with the scheduler on, never shorter than the
+  *       active profile period
+  * @retval Period in ms
+  */
+static uint32_t Sched_IdlePeriod(void)
+{
+    if(sched_enabled && SCHED_IDLE_PERIOD_MS > active_profile->periodMs)
+    {
+        return SCHED_IDLE_PERIOD_MS;
+    }
+    
+    return active_profile->periodMs;
+}
+
+/**
+  * @brief Switch the sensors to the rate requested by the scheduler
+  * @note ACTIVE applies SCHED_ACTIVE_PROFILE at its own period; IDLE returns
+  *       to the active profile at the idle period
+  * @retval None
+  */
+static void Sched_Apply(void)
+{
+    char msg[80];
+    const VL53L0X_Profile *profile = active_profile;
+    uint32_t period_ms = Sched_IdlePeriod();
+    
+    if(RangeSched_GetState(&sched) == RANGE_SCHED_ACTIVE)
+    {
+        profile = VL53L0X_GetProfile(SCHED_ACTIVE_PROFILE);
+        period_ms = profile->periodMs;
+    }
+    
+    sprintf(msg, "Agenda: %s (perfil %s, %lu ms)\r\n",
+            (RangeSched_GetState(&sched) == RANGE_SCHED_ACTIVE) ? "movimento" : "parado",
+            profile->name, (unsigned long)period_ms);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    
+    Sensors_Restart(profile, period_ms);
+}
+
+/**
+  * @brief Handle the "agenda [on [limiar attack decay] | off]" console command
+  * @note Without arguments shows the scheduler state. "on" takes the motion
+  *       threshold (mm), attack and decay times (ms), all three or none
+  * @param arg Text following the command word
+  * @retval None
+  */
+static void Sched_Command(const char *arg)
+{
+    char msg[128];
+    
+    while(*arg == ' ')
+    {
+        arg++;
+    }
+    
+    if(strncmp(arg, "on", 2) == 0)
+    {
+        unsigned long threshold = SCHED_THRESHOLD_MM;
+        unsigned long attack = SCHED_ATTACK_MS;
+        unsigned long decay = SCHED_DECAY_MS;
+        int fields = sscanf(arg + 2, "%lu %lu %lu", &threshold, &attack, &decay);
+        
+        if((fields != EOF && fields != 3) || threshold == 0 || threshold > VL53L0X_THRESHOLD_MAX_MM)
+        {
+            HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nUso: agenda [on [<limiar mm> <attack ms> <decay ms>] | off]\r\n", 63, 100);
+            return;
+        }
+        
+        RangeSched_Config config = { (uint16_t)threshold, attack, decay };
+        RangeSched_Init(&sched, &config);
+        sched_enabled = true;
+    }
+    else if(strcmp(arg, "off") == 0)
+    {
+        RangeSched_Reset(&sched);
+        sched_enabled = false;
+    }
+    else if(*arg != '\0')
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nUso: agenda [on [<limiar mm> <attack ms> <decay ms>] | off]\r\n", 63, 100);
+        return;
+    }
+    
+    sprintf(msg, "\r\nAgenda %s: limiar %u mm, attack %lu ms, decay %lu ms, parado a %lu ms\r\n",
+            !sched_enabled ? "desligada" : (RangeSched_GetState(&sched) == RANGE_SCHED_ACTIVE) ? "em movimento" : "parada",
+            sched.config.thresholdMm, (unsigned long)sched.config.attackMs, (unsigned long)sched.config.decayMs,
+            (unsigned long)Sched_IdlePeriod());
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    
+    /* Liga/desliga: recomeça parado, no período correspondente */
+    if(*arg != '\0' && sensor_initialized_ok && proximity_mode == VL53L0X_THRESHOLD_OFF)
+    {
+        Sensors_Restart(active_profile, Sched_IdlePeriod());
+    }
+}
+
+/**
+  * @brief Handle the "prox [modo] [low] [high]" console command
+  * @note Modes: off, abaixo <mm>, acima <mm>, fora <low> <high>,
+  *       dentro <low> <high>. Without arguments enables "abaixo" at
+  *       PROXIMITY_DISTANCE_MM. Sensors keep ranging in timed mode and raise
+  *       GPIO1 only for samples inside the window
+  * @param arg Text following the command word
+  * @retval None
+  */
+static void Proximity_Command(const char *arg)
+{
+    static const char *const mode_names[] = { "off", "abaixo", "acima", "fora", "dentro" };
+    char msg[80];
+    char *end;
+    VL53L0X_ThresholdMode mode = VL53L0X_THRESHOLD_BELOW;
+    unsigned long low = PROXIMITY_DISTANCE_MM;
+    unsigned long high = 0;
+    
+    while(*arg == ' ')
+    {
+        arg++;
+    }
+    
+    /* Sem argumento: objeto abaixo da distância padrão */
+    if(*arg != '\0')
+    {
+        uint8_t i;
+        size_t len = strcspn(arg, " ");
+        
+        for(i = 0; i < sizeof(mode_names) / sizeof(mode_names[0]); i++)
+        {
+            if(strlen(mode_names[i]) == len && strncmp(arg, mode_names[i], len) == 0)
+            {
+                break;
+            }
+        }
+        if(i == sizeof(mode_names) / sizeof(mode_names[0]))
+        {
+            HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nUso: prox [off|abaixo mm|acima mm|fora mm mm|dentro mm mm]\r\n", 62, 100);
+            return;
+        }
+        mode = (VL53L0X_ThresholdMode)i;
+        arg += len;
+        
+        /* "acima" usa só o limite superior */
+        low = strtoul(arg, &end, 10);
+        arg = end;
+        high = strtoul(arg, &end, 10);
+        if(mode == VL53L0X_THRESHOLD_ABOVE)
+        {
+            high = low;
+            low = 0;
+        }
+    }
+    
+    if(low > VL53L0X_THRESHOLD_MAX_MM || high > VL53L0X_THRESHOLD_MAX_MM)
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nLimite fora da faixa\r\n", 24, 100);
+        return;
+    }
+    
+    if(!sensor_initialized_ok)
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nSensor nao iniciado\r\n", 23, 100);
+        return;
+    }
+    
+    RangeArray_StopAll();
+    
+    /* Sem amostras o agendamento fica parado: volta ao perfil ativo */
+    if(RangeSched_GetState(&sched) == RANGE_SCHED_ACTIVE)
+    {
+        for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+        {
+            RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+            if(sensor->online)
+            {
+                VL53L0X_SetProfile(&sensor->dev, active_profile);
+            }
+        }
+    }
+    RangeSched_Reset(&sched);
+    
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+    {
+        RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+        if(sensor->online &&
+           VL53L0X_SetThresholdWindow(&sensor->dev, mode, (uint16_t)low, (uint16_t)high) != VL53L0X_OK)
+        {
+            mode = VL53L0X_THRESHOLD_OFF;
+        }
+    }
+    
+    /* Janela inválida: volta todos os sensores ao data-ready */
+    if(mode == VL53L0X_THRESHOLD_OFF)
+    {
+        for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+        {
+            RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+            if(sensor->online)
+            {
+                VL53L0X_SetThresholdWindow(&sensor->dev, VL53L0X_THRESHOLD_OFF, 0, 0);
+            }
+        }
+    }
+    
+    proximity_mode = mode;
+    proximity_low_mm = (uint16_t)low;
+    proximity_high_mm = (uint16_t)high;
+    proximity_detected = false;
+    
+    /* LED passa a indicar apenas o estado de proximidade */
+    init_blink_period = false;
+    HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, GPIO_PIN_SET);
+    
+    if(mode == VL53L0X_THRESHOLD_OFF)
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nProximidade desligada\r\n", 25, 100);
+    }
+    else
+    {
+        sprintf(msg, "\r\nProximidade: %s %u..%u mm\r\n", mode_names[mode],
+                proximity_low_mm, proximity_high_mm);
+        HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    }
+    
+    /* Proximidade no período do perfil (base do prazo de liberação) */
+    RangeArray_StartStaggered((mode == VL53L0X_THRESHOLD_OFF) ? Sched_IdlePeriod() : active_profile->periodMs);
+}
+
+/**
+  * @brief Collect threshold events and update the proximity state
+  * @note The interrupt repeats on every sample inside the window, so the
+  *       object is released once no sensor signals for a period plus margin
+  * @retval None
+  */
+static void Proximity_Process(void)
+{
+    bool detected = proximity_detected;
+    
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+    {
+        RangeArray_Sensor *sensor = RangeArray_GetSensor(i);
+        bool event = false;
+        
+        if(sensor->online && VL53L0X_TakeThresholdEvent(&sensor->dev, &event) == VL53L0X_OK && event)
+        {
+            proximity_event_tick = HAL_GetTick();
+            detected = true;
+        }
+    }
+    
+    if(detected && HAL_GetTick() - proximity_event_tick > active_profile->periodMs + PROXIMITY_RELEASE_MARGIN_MS)
+    {
+        detected = false;
+    }
+    
+    if(detected != proximity_detected)
+    {
+        proximity_detected = detected;
+        HAL_GPIO_WritePin(LED_AZUL_GPIO_Port, LED_AZUL_Pin, detected ? GPIO_PIN_RESET : GPIO_PIN_SET);
+        if(detected)
+        {
+            HAL_UART_Transmit(&huart1, (uint8_t*)"Proximidade: objeto detectado\r\n", 31, 100);
+        }
+        else
+        {
+            HAL_UART_Transmit(&huart1, (uint8_t*)"Proximidade: livre\r\n", 20, 100);
+        }
+    }
+}
+
+/**
+  * @brief Start the incremental I2C bus scan
+  * @note Clears the device bitmap; I2C_Scan_Process probes the addresses
+  *       from the main loop and prints the table at the end
+  * @retval None
+  */
+static void I2C_Scan_Start(void)
+{
+    if(scan_active)
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nVarredura I2C em andamento\r\n> ", 32, 100);
+        return;
+    }
+    
+    HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nIniciando I2C Bus Scan (i2cdetect-like)...\r\n", 46, 100);
+    memset((uint8_t*)scan_found, 0, sizeof(scan_found));
+    scan_pending = 0;
+    scan_next_address = I2C_SCAN_FIRST_ADDRESS;
+    scan_start_tick = HAL_GetTick();
+    scan_active = true;
+}
+
+/**
+  * @brief Probe the next addresses of the running scan
+  * @note Keeps up to I2C_SCAN_PROBES_PER_LOOP probes on the bus queue at low
+  *       priority, so sensor readouts always find a free slot and go first.
+  *       Without the asynchronous transport the same number of blocking
+  *       probes runs per call. Prints the table once every probe completed
+  * @retval None
+  */
+static void I2C_Scan_Process(void)
+{
+    I2CBus_Transaction probe;
+    uint8_t probes = 0;
+    
+    if(!scan_active)
+    {
+        return;
+    }
+    
+    probe.op = I2C_BUS_OP_PROBE;
+    probe.priority = I2C_BUS_PRIORITY_LOW;
+    probe.reg = 0;
+    probe.data = NULL;
+    probe.count = 0;
+    probe.callback = I2C_Scan_ProbeDone;
+    
+    while(scan_next_address <= I2C_SCAN_LAST_ADDRESS && scan_pending < I2C_SCAN_PROBES_PER_LOOP &&
+          probes < I2C_SCAN_PROBES_PER_LOOP)
+    {
+        HAL_StatusTypeDef status;
+        
+        probe.address = scan_next_address;
+        probe.context = (void*)(uintptr_t)scan_next_address;
+        
+        /* Contada antes: a sonda pode concluir dentro de I2CBus_Submit. O
+           contador também é decrementado pela interrupção de conclusão, então
+           o ++/-- do loop não pode ser interrompido no meio */
+        __disable_irq();
+        scan_pending++;
+        __enable_irq();
+        status = I2CBus_Submit(&hi2c1, &probe);
+        if(status == HAL_BUSY)
+        {
+            /* Fila cheia: tenta na próxima volta */
+            __disable_irq();
+            scan_pending--;
+            __enable_irq();
+            break;
+        }
+        if(status != HAL_OK)
+        {
+            /* Sem transporte assíncrono: sonda bloqueante */
+            HAL_StatusTypeDef found = I2CBus_Probe(&hi2c1, scan_next_address);
+            __disable_irq();
+            I2C_Scan_ProbeDone(probe.context, found);
+            __enable_irq();
+        }
+        
+        scan_next_address++;
+        probes++;
+    }
+    
+    if(scan_next_address > I2C_SCAN_LAST_ADDRESS && scan_pending == 0)
+    {
+        scan_active = false;
+        I2C_Scan_Print();
+    }
+}
+
+/**
+  * @brief Record the result of one probe
+  * @note Bus completion callback (interrupt context)
+  * @param context Probed address
+  * @param status HAL_OK if the device acknowledged
+  * @retval None
+  */
+static void I2C_Scan_ProbeDone(void *context, HAL_StatusTypeDef status)
+{
+    uint8_t address = (uint8_t)(uintptr_t)context;
+    
+    if(status == HAL_OK)
+    {
+        scan_found[address / 8] |= (uint8_t)(1U << (address % 8));
+    }
+    scan_pending--;
+}
+
+/**
+  * @brief Print the scan table (i2cdetect-like) from the device bitmap
+  * @retval None
+  */
+static void I2C_Scan_Print(void)
+{
+    char msg[64];
+    uint8_t devices = 0;
+    
+    HAL_UART_Transmit(&huart1, (uint8_t*)"     0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F\r\n", 53, 100);
+    
+    for(uint8_t i = 0; i < 8; i++)
+    {
+        char *p = msg + sprintf(msg, "%02X: ", i * 16);
+        
+        for(uint8_t j = 0; j < 16; j++)
+        {
+            uint8_t address = (i * 16) + j;
+            if(address < I2C_SCAN_FIRST_ADDRESS || address > I2C_SCAN_LAST_ADDRESS)
+            {
+                p += sprintf(p, "   ");
+            }
+            else if(scan_found[address / 8] & (1U << (address % 8)))
+            {
+                p += sprintf(p, "%02X ", address);
+                devices++;
+            }
+            else
+            {
+                p += sprintf(p, "-- ");
+            }
+        }
+        p += sprintf(p, "\r\n");
+        HAL_UART_Transmit(&huart1, (uint8_t*)msg, p - msg, 100);
+    }
+    
+    sprintf(msg, "%u dispositivo(s) em %lu ms\r\n> ", devices, (unsigned long)(HAL_GetTick() - scan_start_tick));
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+}
+
+/**
+  * @brief Handle the "i2c_vel [100 | 400 [2|16_9] | teste]" console command
+  * @note Without arguments shows the I2C1 speed and counters. A speed
+  *       reprograms the bus at once (duty cycle only in fast mode, default
+  *       2); "teste" runs I2C_Speed_Test
+  * @param arg Text following the command word
+  * @retval None
+  */
+static void I2C_Speed_Command(const char *arg)
+{
+    char msg[160];
+    char duty[8] = "2";
+    unsigned long khz = 0;
+    I2CBus_Stats stats;
+    
+    while(*arg == ' ')
+    {
+        arg++;
+    }
+    
+    if(strcmp(arg, "teste") == 0)
+    {
+        I2C_Speed_Test();
+        return;
+    }
+    
+    if(*arg != '\0')
+    {
+        int fields = sscanf(arg, "%lu %7s", &khz, duty);
+        bool duty_ok = (strcmp(duty, "2") == 0 || strcmp(duty, "16_9") == 0);
+        uint32_t duty_cycle = (strcmp(duty, "16_9") == 0) ? I2C_DUTYCYCLE_16_9 : I2C_DUTYCYCLE_2;
+        
+        if(fields < 1 || (khz != 100 && khz != 400) || !duty_ok ||
+           I2CBus_SetSpeed(&hi2c1, khz * 1000, duty_cycle) != HAL_OK)
+        {
+            HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nUso: i2c_vel [100 | 400 [2|16_9] | teste]\r\n", 45, 100);
+            return;
+        }
+    }
+    
+    I2CBus_GetStats(&hi2c1, &stats);
+    sprintf(msg, "\r\nI2C1: %lu kHz%s, %lu transf., NACK %lu, ARLO %lu, BERR %lu, timeout %lu, fallback %lu\r\n",
+            (unsigned long)(hi2c1.Init.ClockSpeed / 1000),
+            (hi2c1.Init.ClockSpeed <= I2C_BUS_SPEED_STANDARD) ? "" :
+            (hi2c1.Init.DutyCycle == I2C_DUTYCYCLE_16_9) ? " (16:9)" : " (2)",
+            (unsigned long)stats.transfers, (unsigned long)stats.nackErrors, (unsigned long)stats.arloErrors,
+            (unsigned long)stats.busErrors, (unsigned long)stats.timeouts, (unsigned long)stats.fallbacks);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    sprintf(msg, "Recuperacoes %lu (falhas %lu), ultima %lu ms, max %lu ms\r\n",
+            (unsigned long)stats.recoveries, (unsigned long)stats.recoveryFailures,
+            (unsigned long)stats.lastRecoveryMs, (unsigned long)stats.maxRecoveryMs);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+}
+
+/**
+  * @brief Service the bus queue and restart ranging after a recovery
+  * @note A reading lost while the bus was hung leaves the sensor interrupt
+  *       latched (GPIO1 low, no further EXTI edge), so the schedule is
+  *       restarted, which clears it
+  * @retval None
+  */
+static void Bus_Process(void)
+{
+    char msg[80];
+    I2CBus_Stats stats;
+    
+    /* Fila do barramento: retomada após erros e transferências presas */
+    I2CBus_Process(&hi2c1);
+    
+    I2CBus_GetStats(&hi2c1, &stats);
+    if(stats.recoveries == bus_recoveries)
+    {
+        return;
+    }
+    bus_recoveries = stats.recoveries;
+    
+    sprintf(msg, "I2C: barramento recuperado em %lu ms\r\n", (unsigned long)stats.lastRecoveryMs);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    
+    if(sensor_initialized_ok && RangeArray_Restart() != VL53L0X_OK)
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"I2C: falha ao religar os sensores\r\n", 35, 100);
+    }
+}
+
+/**
+  * @brief Measure result-block reads at each bus speed
+  * @note Reads the result block of the first sensor online for
+  *       I2C_TEST_DURATION_MS at 100 kHz, 400 kHz (2) and 400 kHz (16:9),
+  *       with the automatic fallback off, and reports throughput and errors.
+  *       The previous speed is restored afterwards
+  * @retval None
+  */
+static void I2C_Speed_Test(void)
+{
+    static const struct {
+        uint32_t clockHz;
+        uint32_t dutyCycle;
+        const char *name;
+    } speeds[] = {
+        { I2C_BUS_SPEED_STANDARD, I2C_DUTYCYCLE_2, "100 kHz" },
+        { I2C_BUS_SPEED_FAST, I2C_DUTYCYCLE_2, "400 kHz (2)" },
+        { I2C_BUS_SPEED_FAST, I2C_DUTYCYCLE_16_9, "400 kHz (16:9)" }
+    };
+    uint32_t clock_hz = hi2c1.Init.ClockSpeed;
+    uint32_t duty_cycle = hi2c1.Init.DutyCycle;
+    uint8_t block[VL53L0X_RESULT_BLOCK_SIZE];
+    uint8_t address = 0;
+    char msg[128];
+    
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++)
+    {
+        if(RangeArray_GetSensor(i)->online)
+        {
+            address = RangeArray_GetSensor(i)->dev.address;
+            break;
+        }
+    }
+    if(address == 0)
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\nNenhum sensor online\r\n", 24, 100);
+        return;
+    }
+    
+    sprintf(msg, "\r\nLeituras do bloco de resultado (0x%02X, %u bytes) por %u ms:\r\n",
+            address, (unsigned int)sizeof(block), I2C_TEST_DURATION_MS);
+    HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    
+    /* Erros aqui são o resultado do teste, não motivo para trocar a velocidade */
+    I2CBus_SetFallback(&hi2c1, false);
+    
+    for(uint8_t s = 0; s < sizeof(speeds) / sizeof(speeds[0]); s++)
+    {
+        I2CBus_Stats before;
+        I2CBus_Stats after;
+        uint32_t reads = 0;
+        uint32_t start_tick;
+        uint32_t elapsed;
+        
+        if(I2CBus_SetSpeed(&hi2c1, speeds[s].clockHz, speeds[s].dutyCycle) != HAL_OK)
+        {
+            continue;
+        }
+        
+        I2CBus_GetStats(&hi2c1, &before);
+        start_tick = HAL_GetTick();
+        do
+        {
+            if(I2CBus_Read(&hi2c1, address, VL53L0X_REG_RESULT_RANGE_STATUS, block, sizeof(block)) == HAL_OK)
+            {
+                reads++;
+            }
+            elapsed = HAL_GetTick() - start_tick;
+        } while(elapsed < I2C_TEST_DURATION_MS);
+        I2CBus_GetStats(&hi2c1, &after);
+        
+        sprintf(msg, "%s: %lu leituras, %lu B/s, NACK %lu, ARLO %lu, outros %lu\r\n",
+                speeds[s].name, (unsigned long)reads, (unsigned long)(reads * sizeof(block) * 1000 / elapsed),
+                (unsigned long)(after.nackErrors - before.nackErrors),
+                (unsigned long)(after.arloErrors - before.arloErrors),
+                (unsigned long)((after.busErrors + after.timeouts) - (before.busErrors + before.timeouts)));
+        HAL_UART_Transmit(&huart1, (uint8_t*)msg, strlen(msg), 100);
+    }
+    
+    I2CBus_SetSpeed(&hi2c1, clock_hz, duty_cycle);
+    I2CBus_SetFallback(&hi2c1, true);
+}
+
+/**
+  * @brief EXTI line detection callback
+  * @param GPIO_Pin Pin that triggered the interrupt
+  * @retval None
+  */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    /* Encaminha o GPIO1 (data-ready) ao sensor ligado a este pino */
+    RangeArray_DataReadyCallback(GPIO_Pin);
 }
 
 /**
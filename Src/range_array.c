@@ -0,0 +1,175 @@
+#include "range_array.h"
+#include "i2c_bus.h"
+#include "main.h"
+
+#define RANGE_ARRAY_XSHUT_LOW_MS    2       // ms - XSHUT em nível baixo para garantir o reset
+#define RANGE_ARRAY_BOOT_TIMEOUT_MS 3       // ms - Boot após liberar XSHUT (típico 1.2ms)
+#define RANGE_ARRAY_DISTANCE_NONE   0xFFFF  // Nenhuma leitura ainda
+
+/* Ligação física de cada posição: XSHUT em PB12..PB15, GPIO1 em PB0/PB1/PB10/PB11 */
+static RangeArray_Sensor sensors[RANGE_ARRAY_MAX_SENSORS] = {
+    { .xshutPort = VL53L0X_XSHUT1_GPIO_Port, .xshutPin = VL53L0X_XSHUT1_Pin, .gpio1Pin = VL53L0X_GPIO1_Pin },
+    { .xshutPort = VL53L0X_XSHUT2_GPIO_Port, .xshutPin = VL53L0X_XSHUT2_Pin, .gpio1Pin = VL53L0X_S2_GPIO1_Pin },
+    { .xshutPort = VL53L0X_XSHUT3_GPIO_Port, .xshutPin = VL53L0X_XSHUT3_Pin, .gpio1Pin = VL53L0X_S3_GPIO1_Pin },
+    { .xshutPort = VL53L0X_XSHUT4_GPIO_Port, .xshutPin = VL53L0X_XSHUT4_Pin, .gpio1Pin = VL53L0X_S4_GPIO1_Pin },
+};
+static uint8_t online_count = 0;
+static uint32_t stagger_period_ms = 0;
+
+/* Private function prototypes */
+static bool RangeArray_WaitDevice(I2C_HandleTypeDef *hi2c, uint8_t address);
+
+uint8_t RangeArray_Init(I2C_HandleTypeDef *hi2c)
+{
+    online_count = 0;
+    
+    /* Todos em standby: só o sensor liberado responde em 0x29 */
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++) {
+        HAL_GPIO_WritePin(sensors[i].xshutPort, sensors[i].xshutPin, GPIO_PIN_RESET);
+        sensors[i].online = false;
+        sensors[i].startPending = false;
+        sensors[i].lastDistance_mm = RANGE_ARRAY_DISTANCE_NONE;
+        RangeTracker_Init(&sensors[i].tracker);
+    }
+    HAL_Delay(RANGE_ARRAY_XSHUT_LOW_MS);
+    
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++) {
+        uint8_t target = RANGE_ARRAY_BASE_ADDRESS + i;
+    
+        HAL_GPIO_WritePin(sensors[i].xshutPort, sensors[i].xshutPin, GPIO_PIN_SET);
+    
+        if(RangeArray_WaitDevice(hi2c, VL53L0X_DEFAULT_ADDRESS)) {
+            VL53L0X_DevInit(&sensors[i].dev, hi2c, VL53L0X_DEFAULT_ADDRESS);
+            sensors[i].online = (VL53L0X_SetAddress(&sensors[i].dev, target) == VL53L0X_OK);
+        }
+        else if(I2CBus_Probe(hi2c, target) == HAL_OK) {
+            /* Endereço já atribuído antes de um reset só do MCU */
+            VL53L0X_DevInit(&sensors[i].dev, hi2c, target);
+            sensors[i].online = true;
+        }
+    
+        if(sensors[i].online) {
+            online_count++;
+        }
+        else {
+            /* Posição vazia: mantém em standby */
+            HAL_GPIO_WritePin(sensors[i].xshutPort, sensors[i].xshutPin, GPIO_PIN_RESET);
+        }
+    }
+    
+    return online_count;
+}
+
+uint8_t RangeArray_GetCount(void)
+{
+    return online_count;
+}
+
+RangeArray_Sensor *RangeArray_GetSensor(uint8_t index)
+{
+    if(index >= RANGE_ARRAY_MAX_SENSORS) {
+        return NULL;
+    }
+    
+    return &sensors[index];
+}
+
+void RangeArray_StartStaggered(uint32_t period_ms)
+{
+    uint32_t now = HAL_GetTick();
+    uint8_t phase = 0;
+    
+    stagger_period_ms = period_ms;
+    
+    /* Fases igualmente espaçadas dentro do período */
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++) {
+        if(!sensors[i].online) {
+            continue;
+        }
+        sensors[i].startTick = now + (period_ms * phase) / online_count;
+        sensors[i].startPending = true;
+        phase++;
+    }
+}
+
+VL53L0X_Status RangeArray_Process(void)
+{
+    VL53L0X_Status status = VL53L0X_OK;
+    uint32_t now = HAL_GetTick();
+    
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++) {
+        if(!sensors[i].startPending || (int32_t)(now - sensors[i].startTick) < 0) {
+            continue;
+        }
+    
+        sensors[i].startPending = false;
+        if(VL53L0X_StartContinuous(&sensors[i].dev, stagger_period_ms) != VL53L0X_OK) {
+            status = VL53L0X_ERROR;
+        }
+    }
+    
+    return status;
+}
+
+VL53L0X_Status RangeArray_StopAll(void)
+{
+    VL53L0X_Status status = VL53L0X_OK;
+    
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++) {
+        sensors[i].startPending = false;
+        if(sensors[i].online && VL53L0X_StopContinuous(&sensors[i].dev) != VL53L0X_OK) {
+            status = VL53L0X_ERROR;
+        }
+    }
+    
+    return status;
+}
+
+VL53L0X_Status RangeArray_Restart(void)
+{
+    VL53L0X_Status status = RangeArray_StopAll();
+    
+    if(stagger_period_ms != 0) {
+        RangeArray_StartStaggered(stagger_period_ms);
+    }
+    
+    return status;
+}
+
+void RangeArray_DataReadyCallback(uint16_t gpio_pin)
+{
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++) {
+        if(sensors[i].online && sensors[i].gpio1Pin == gpio_pin) {
+            VL53L0X_DataReadyCallback(&sensors[i].dev);
+        }
+    }
+}
+
+uint16_t RangeArray_GetNearestDistance(void)
+{
+    uint16_t nearest = RANGE_ARRAY_DISTANCE_NONE;
+    
+    for(uint8_t i = 0; i < RANGE_ARRAY_MAX_SENSORS; i++) {
+        if(sensors[i].online && sensors[i].lastDistance_mm < nearest) {
+            nearest = sensors[i].lastDistance_mm;
+        }
+    }
+    
+    return nearest;
+}
+
+/* Private Functions */
+
+/* Aguarda o sensor recém-liberado do XSHUT responder (sondas pela fila do i2c_bus) */
+static bool RangeArray_WaitDevice(I2C_HandleTypeDef *hi2c, uint8_t address)
+{
+    uint32_t start = HAL_GetTick();
+    
+    do {
+        if(I2CBus_Probe(hi2c, address) == HAL_OK) {
+            return true;
+        }
+    } while((HAL_GetTick() - start) < RANGE_ARRAY_BOOT_TIMEOUT_MS);
+    
+    return false;
+}
@@ -0,0 +1,257 @@
+#include "range_filter.h"
+#include <string.h>
+
+/* Private function prototypes */
+static RangeFilter_Stage *RangeFilter_Append(RangeFilter *filter, RangeFilter_StageType type);
+static void RangeFilter_WindowPush(RangeFilter_Stage *stage, uint16_t value);
+static uint16_t RangeFilter_WindowMedian(const RangeFilter_Stage *stage);
+static bool RangeFilter_Gate(RangeFilter_Stage *stage, uint16_t *value);
+static void RangeFilter_Hampel(RangeFilter_Stage *stage, uint16_t *value);
+static void RangeFilter_Ema(RangeFilter_Stage *stage, uint16_t *value, uint16_t sigma_mm);
+
+void RangeFilter_Init(RangeFilter *filter)
+{
+    memset(filter, 0, sizeof(RangeFilter));
+}
+
+bool RangeFilter_AddGate(RangeFilter *filter, uint16_t max_jump_mm, uint8_t valid_reads)
+{
+    RangeFilter_Stage *stage;
+    
+    if(valid_reads == 0 || (stage = RangeFilter_Append(filter, RANGE_FILTER_GATE)) == NULL) {
+        return false;
+    }
+    stage->param = max_jump_mm;
+    stage->param2 = valid_reads;
+    
+    return true;
+}
+
+bool RangeFilter_AddMedian(RangeFilter *filter, uint8_t size)
+{
+    RangeFilter_Stage *stage;
+    
+    if(size == 0 || size > RANGE_FILTER_MAX_WINDOW || (stage = RangeFilter_Append(filter, RANGE_FILTER_MEDIAN)) == NULL) {
+        return false;
+    }
+    stage->param = size;
+    
+    return true;
+}
+
+bool RangeFilter_AddHampel(RangeFilter *filter, uint8_t size, uint8_t k_tenths)
+{
+    RangeFilter_Stage *stage;
+    
+    if(size < 3 || size > RANGE_FILTER_MAX_WINDOW || k_tenths == 0 ||
+       (stage = RangeFilter_Append(filter, RANGE_FILTER_HAMPEL)) == NULL) {
+        return false;
+    }
+    stage->param = size;
+    stage->param2 = k_tenths;
+    
+    return true;
+}
+
+bool RangeFilter_AddEma(RangeFilter *filter, uint16_t alpha_q8, uint16_t sigma_ref_mm)
+{
+    RangeFilter_Stage *stage;
+    
+    if(alpha_q8 == 0 || alpha_q8 > 256 || (stage = RangeFilter_Append(filter, RANGE_FILTER_EMA)) == NULL) {
+        return false;
+    }
+    stage->param = alpha_q8;
+    stage->param2 = sigma_ref_mm;
+    
+    return true;
+}
+
+void RangeFilter_SetGate(RangeFilter *filter, uint16_t max_jump_mm, uint8_t valid_reads)
+{
+    for(uint8_t i = 0; i < filter->count; i++) {
+        if(filter->stages[i].type == RANGE_FILTER_GATE && valid_reads > 0) {
+            filter->stages[i].param = max_jump_mm;
+            filter->stages[i].param2 = valid_reads;
+        }
+    }
+}
+
+void RangeFilter_Reset(RangeFilter *filter)
+{
+    for(uint8_t i = 0; i < filter->count; i++) {
+        RangeFilter_Stage *stage = &filter->stages[i];
+        stage->head = 0;
+        stage->fill = 0;
+        stage->count = 0;
+        stage->last = 0;
+        stage->ema = 0;
+    }
+}
+
+void RangeFilter_Invalidate(RangeFilter *filter)
+{
+    for(uint8_t i = 0; i < filter->count; i++) {
+        if(filter->stages[i].type == RANGE_FILTER_GATE) {
+            filter->stages[i].count = 0;
+        }
+    }
+}
+
+bool RangeFilter_Process(RangeFilter *filter, uint16_t distance_mm, uint16_t sigma_mm, uint16_t *output)
+{
+    uint16_t value = distance_mm;
+    
+    for(uint8_t i = 0; i < filter->count; i++) {
+        RangeFilter_Stage *stage = &filter->stages[i];
+    
+        switch(stage->type) {
+            case RANGE_FILTER_GATE:
+                /* Amostra retida: os estágios seguintes não a veem */
+                if(!RangeFilter_Gate(stage, &value)) {
+                    return false;
+                }
+                break;
+            case RANGE_FILTER_MEDIAN:
+                RangeFilter_WindowPush(stage, value);
+                value = RangeFilter_WindowMedian(stage);
+                break;
+            case RANGE_FILTER_HAMPEL:
+                RangeFilter_Hampel(stage, &value);
+                break;
+            case RANGE_FILTER_EMA:
+                RangeFilter_Ema(stage, &value, sigma_mm);
+                break;
+        }
+    }
+    
+    *output = value;
+    return true;
+}
+
+/* Private Functions */
+
+static RangeFilter_Stage *RangeFilter_Append(RangeFilter *filter, RangeFilter_StageType type)
+{
+    RangeFilter_Stage *stage;
+    
+    if(filter->count >= RANGE_FILTER_MAX_STAGES) {
+        return NULL;
+    }
+    
+    stage = &filter->stages[filter->count++];
+    memset(stage, 0, sizeof(RangeFilter_Stage));
+    stage->type = type;
+    
+    return stage;
+}
+
+/* Insere no anel e mantém a cópia ordenada: remove a amostra mais antiga e
+   insere a nova por deslocamento, O(N) por amostra */
+static void RangeFilter_WindowPush(RangeFilter_Stage *stage, uint16_t value)
+{
+    uint8_t size = (uint8_t)stage->param;
+    uint8_t pos;
+    
+    if(stage->fill == size) {
+        uint16_t oldest = stage->ring[stage->head];
+    
+        pos = 0;
+        while(pos < stage->fill && stage->sorted[pos] != oldest) {
+            pos++;
+        }
+        for(; pos + 1 < stage->fill; pos++) {
+            stage->sorted[pos] = stage->sorted[pos + 1];
+        }
+        stage->fill--;
+    }
+    
+    for(pos = stage->fill; pos > 0 && stage->sorted[pos - 1] > value; pos--) {
+        stage->sorted[pos] = stage->sorted[pos - 1];
+    }
+    stage->sorted[pos] = value;
+    stage->fill++;
+    
+    stage->ring[stage->head] = value;
+    stage->head = (stage->head + 1) % size;
+}
+
+static uint16_t RangeFilter_WindowMedian(const RangeFilter_Stage *stage)
+{
+    return stage->sorted[stage->fill / 2];
+}
+
+/* Política original de VL53L0X_ReadDistance, reancorando após um salto */
+static bool RangeFilter_Gate(RangeFilter_Stage *stage, uint16_t *value)
+{
+    uint16_t diff = (*value > stage->last) ? (*value - stage->last) : (stage->last - *value);
+    
+    if(stage->count > 0 && diff > stage->param) {
+        stage->count = 1;
+    } else if(stage->count < 0xFF) {
+        stage->count++;
+    }
+    stage->last = *value;
+    
+    return (stage->count >= stage->param2);
+}
+
+static void RangeFilter_Hampel(RangeFilter_Stage *stage, uint16_t *value)
+{
+    uint16_t deviation[RANGE_FILTER_MAX_WINDOW];
+    uint16_t median;
+    uint16_t diff;
+    uint32_t threshold;
+    uint8_t pos;
+    
+    RangeFilter_WindowPush(stage, *value);
+    median = RangeFilter_WindowMedian(stage);
+    
+    /* MAD: mediana dos desvios absolutos (ordenação por inserção, N <= 7) */
+    for(uint8_t i = 0; i < stage->fill; i++) {
+        diff = (stage->sorted[i] > median) ? (stage->sorted[i] - median) : (median - stage->sorted[i]);
+        for(pos = i; pos > 0 && deviation[pos - 1] > diff; pos--) {
+            deviation[pos] = deviation[pos - 1];
+        }
+        deviation[pos] = diff;
+    }
+    
+    /* k * 1.4826 * MAD (estimador do desvio padrão) */
+    threshold = ((uint32_t)deviation[stage->fill / 2] * stage->param2 * 1483 + 5000) / 10000;
+    if(threshold < RANGE_FILTER_HAMPEL_MIN_MM) {
+        threshold = RANGE_FILTER_HAMPEL_MIN_MM;
+    }
+    
+    diff = (*value > median) ? (*value - median) : (median - *value);
+    if(diff > threshold) {
+        *value = median;
+    }
+}
+
+static void RangeFilter_Ema(RangeFilter_Stage *stage, uint16_t *value, uint16_t sigma_mm)
+{
+    uint32_t alpha = stage->param;
+    uint32_t target = (uint32_t)*value << 8;
+    
+    /* Primeira amostra inicializa a saída */
+    if(stage->fill == 0) {
+        stage->ema = target;
+        stage->fill = 1;
+        return;
+    }
+    
+    /* Amostras incertas pesam menos: alfa * ref / (ref + sigma) */
+    if(stage->param2 > 0) {
+        alpha = (alpha * stage->param2) / ((uint32_t)stage->param2 + sigma_mm);
+        if(alpha == 0) {
+            alpha = 1;
+        }
+    }
+    
+    if(target >= stage->ema) {
+        stage->ema += ((target - stage->ema) * alpha) >> 8;
+    } else {
+        stage->ema -= ((stage->ema - target) * alpha) >> 8;
+    }
+    
+    *value = (uint16_t)((stage->ema + 0x80) >> 8);
+}
@@ -0,0 +1,80 @@
+#include "range_sched.h"
+#include <string.h>
+
+/* Private function prototypes */
+static bool RangeSched_Elapsed(uint32_t since, uint32_t timestamp, uint32_t duration_ms);
+
+void RangeSched_Init(RangeSched *sched, const RangeSched_Config *config)
+{
+    memcpy(&sched->config, config, sizeof(RangeSched_Config));
+    RangeSched_Reset(sched);
+}
+
+void RangeSched_Reset(RangeSched *sched)
+{
+    sched->state = RANGE_SCHED_IDLE;
+    sched->referenceValid = 0;
+    sched->attackPending = false;
+    sched->attackTick = 0;
+    sched->motionTick = 0;
+}
+
+bool RangeSched_Update(RangeSched *sched, uint8_t channel, uint16_t distance_mm, uint32_t timestamp)
+{
+    RangeSched_State previous = sched->state;
+    uint8_t mask;
+    bool motion;
+    
+    if(channel >= RANGE_SCHED_MAX_CHANNELS) {
+        return false;
+    }
+    mask = (uint8_t)(1U << channel);
+    
+    /* Primeira amostra do canal só define a referência */
+    if(!(sched->referenceValid & mask)) {
+        sched->reference[channel] = distance_mm;
+        sched->referenceValid |= mask;
+        motion = false;
+    } else {
+        uint16_t diff = (distance_mm > sched->reference[channel]) ? (distance_mm - sched->reference[channel]) :
+                        (sched->reference[channel] - distance_mm);
+        motion = (diff > sched->config.thresholdMm);
+    }
+    
+    if(motion) {
+        /* A referência acompanha o alvo: movimento contínuo continua sendo detectado */
+        sched->reference[channel] = distance_mm;
+    
+        if(sched->state == RANGE_SCHED_IDLE) {
+            /* Movimento interrompido por mais que o attack recomeça a contagem */
+            if(!sched->attackPending || RangeSched_Elapsed(sched->motionTick, timestamp, sched->config.attackMs + 1)) {
+                sched->attackPending = true;
+                sched->attackTick = timestamp;
+            }
+            if(RangeSched_Elapsed(sched->attackTick, timestamp, sched->config.attackMs)) {
+                sched->state = RANGE_SCHED_ACTIVE;
+                sched->attackPending = false;
+            }
+        }
+        sched->motionTick = timestamp;
+    } else if(sched->state == RANGE_SCHED_ACTIVE &&
+              RangeSched_Elapsed(sched->motionTick, timestamp, sched->config.decayMs)) {
+        sched->state = RANGE_SCHED_IDLE;
+    }
+    
+    return (sched->state != previous);
+}
+
+RangeSched_State RangeSched_GetState(const RangeSched *sched)
+{
+    return sched->state;
+}
+
+/* Private Functions */
+
+/* Amostras de sensores diferentes chegam fora de ordem: instantes anteriores
+   a "since" contam como nenhum tempo decorrido */
+static bool RangeSched_Elapsed(uint32_t since, uint32_t timestamp, uint32_t duration_ms)
+{
+    return ((int32_t)(timestamp - since) >= (int32_t)duration_ms);
+}
@@ -0,0 +1,142 @@
+#include "range_tracker.h"
+#include <string.h>
+
+#define RANGE_TRACKER_MAX_RANGE_Q8      ((int32_t)VL53L0X_THRESHOLD_MAX_MM << 8)
+#define RANGE_TRACKER_MAX_SPEED_Q8      ((int32_t)RANGE_TRACKER_MAX_SPEED << 8)
+
+/* Private function prototypes */
+static int32_t RangeTracker_Displacement(int32_t velocity, uint32_t dt_ms);
+static uint32_t RangeTracker_Alpha(const VL53L0X_RangingData *ranging_data);
+static void RangeTracker_Restart(RangeTracker *tracker, const VL53L0X_RangingData *ranging_data);
+
+void RangeTracker_Init(RangeTracker *tracker)
+{
+    memset(tracker, 0, sizeof(RangeTracker));
+}
+
+bool RangeTracker_Update(RangeTracker *tracker, const VL53L0X_RangingData *ranging_data)
+{
+    uint32_t dt_ms;
+    uint32_t alpha;
+    uint32_t beta;
+    int32_t predicted;
+    int32_t residual;
+    
+    /* Sem retorno utilizável: mantém a estimativa */
+    if((ranging_data->rangeStatus != VL53L0X_RANGE_VALID && !ranging_data->flagged) ||
+       ranging_data->sigma >= VL53L0X_SIGMA_MAX) {
+        return false;
+    }
+    
+    dt_ms = ranging_data->timestamp - tracker->timestamp;
+    if(!tracker->initialized || dt_ms > RANGE_TRACKER_MAX_GAP_MS) {
+        RangeTracker_Restart(tracker, ranging_data);
+        return true;
+    }
+    if(dt_ms == 0) {
+        dt_ms = 1;
+    }
+    
+    /* Predição no instante da amostra e resíduo */
+    predicted = tracker->position + RangeTracker_Displacement(tracker->velocity, dt_ms);
+    residual = ((int32_t)ranging_data->distance_mm << 8) - predicted;
+    
+    /* Resíduo grande isolado é ignorado; repetido indica outro alvo */
+    if(residual > ((int32_t)RANGE_TRACKER_RESET_MM << 8) || residual < -((int32_t)RANGE_TRACKER_RESET_MM << 8)) {
+        if(++tracker->outliers >= RANGE_TRACKER_RESET_COUNT) {
+            RangeTracker_Restart(tracker, ranging_data);
+            return true;
+        }
+        return false;
+    }
+    tracker->outliers = 0;
+    
+    /* Ganhos alfa-beta (beta = alfa² / (2 - alfa)), ponderados pela confiança */
+    alpha = RangeTracker_Alpha(ranging_data);
+    beta = (alpha * alpha) / (512 - alpha);
+    
+    tracker->position = predicted + (int32_t)(((int64_t)residual * alpha) >> 8);
+    tracker->velocity += (int32_t)((((int64_t)residual * beta) >> 8) * 1000 / (int32_t)dt_ms);
+    tracker->timestamp = ranging_data->timestamp;
+    
+    if(tracker->velocity > RANGE_TRACKER_MAX_SPEED_Q8) {
+        tracker->velocity = RANGE_TRACKER_MAX_SPEED_Q8;
+    } else if(tracker->velocity < -RANGE_TRACKER_MAX_SPEED_Q8) {
+        tracker->velocity = -RANGE_TRACKER_MAX_SPEED_Q8;
+    }
+    
+    return true;
+}
+
+uint16_t RangeTracker_GetRange(const RangeTracker *tracker)
+{
+    if(tracker->position <= 0) {
+        return 0;
+    }
+    
+    return (uint16_t)((tracker->position + 0x80) >> 8);
+}
+
+int16_t RangeTracker_GetVelocity(const RangeTracker *tracker)
+{
+    return (int16_t)(tracker->velocity / 256);
+}
+
+uint16_t RangeTracker_Predict(const RangeTracker *tracker, uint32_t timestamp)
+{
+    uint32_t dt_ms = timestamp - tracker->timestamp;
+    int32_t position;
+    
+    if(!tracker->initialized) {
+        return 0;
+    }
+    
+    /* Instante anterior à última amostra (dt "negativo"): sem extrapolação */
+    if(dt_ms > 0x80000000UL) {
+        dt_ms = 0;
+    } else if(dt_ms > RANGE_TRACKER_MAX_PREDICT_MS) {
+        dt_ms = RANGE_TRACKER_MAX_PREDICT_MS;
+    }
+    
+    position = tracker->position + RangeTracker_Displacement(tracker->velocity, dt_ms);
+    if(position <= 0) {
+        return 0;
+    }
+    if(position > RANGE_TRACKER_MAX_RANGE_Q8) {
+        position = RANGE_TRACKER_MAX_RANGE_Q8;
+    }
+    
+    return (uint16_t)((position + 0x80) >> 8);
+}
+
+/* Private Functions */
+
+/* Deslocamento (mm Q8) em dt_ms: v * dt / 1000 via multiplicação por
+   2^32 / 1000, sem divisão de 64 bits */
+static int32_t RangeTracker_Displacement(int32_t velocity, uint32_t dt_ms)
+{
+    return (int32_t)(((int64_t)velocity * (int32_t)dt_ms * 4294967LL) >> 32);
+}
+
+/* Ganho de posição: alfa * ref / (ref + sigma) * min(sinal / sinal_ref, 1) */
+static uint32_t RangeTracker_Alpha(const VL53L0X_RangingData *ranging_data)
+{
+    uint32_t alpha = (RANGE_TRACKER_ALPHA * RANGE_TRACKER_SIGMA_REF_MM) /
+                     (RANGE_TRACKER_SIGMA_REF_MM + (uint32_t)ranging_data->sigma);
+    
+    if(ranging_data->signalRate < RANGE_TRACKER_SIGNAL_REF) {
+        alpha = (alpha * ranging_data->signalRate) / RANGE_TRACKER_SIGNAL_REF;
+    }
+    
+    return (alpha == 0) ? 1 : alpha;
+}
+
+/* Recomeça o rastreio parado na amostra atual */
+static void RangeTracker_Restart(RangeTracker *tracker, const VL53L0X_RangingData *ranging_data)
+{
+    tracker->position = (int32_t)ranging_data->distance_mm << 8;
+    tracker->velocity = 0;
+    tracker->timestamp = ranging_data->timestamp;
+    tracker->outliers = 0;
+    tracker->initialized = true;
+}
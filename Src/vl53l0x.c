@@ -1,195 +1,1970 @@
 #include "vl53l0x.h"
+#include "i2c_bus.h"
 #include <string.h>
 #include <stdbool.h>
-#include <stdlib.h>
 #include <stdint.h>
 
-/* Private variables */
-static uint16_t last_valid_distance = 0;
-static uint8_t valid_reading_count = 0;
-static VL53L0X_RangingData last_ranging_data = {0};
+/* Private typedef */
+typedef struct {
+    uint8_t reg;
+    uint8_t value;
+} VL53L0X_RegValue;
+
+typedef struct {
+    bool tcc;
+    bool msrc;
+    bool dss;
+    bool pre_range;
+    bool final_range;
+} VL53L0X_SequenceStepEnables;
+
+typedef struct {
+    uint8_t pre_range_vcsel_period_pclks;
+    uint8_t final_range_vcsel_period_pclks;
+    uint16_t msrc_dss_tcc_mclks;
+    uint16_t pre_range_mclks;
+    uint16_t final_range_mclks;
+    uint32_t msrc_dss_tcc_us;
+    uint32_t pre_range_us;
+    uint32_t final_range_us;
+} VL53L0X_SequenceStepTimeouts;
+
+typedef struct {
+    uint8_t first;
+    uint8_t count;
+} VL53L0X_ShadowRange;
+
+typedef struct {
+    uint8_t valid_phase_high;
+    uint8_t vcsel_width;
+    uint8_t phasecal_timeout;
+    uint8_t phasecal_lim;
+} VL53L0X_FinalRangeVcselConfig;
+
+/* Private define */
+/* Overheads (µs) de cada etapa da sequência, usados no cálculo do timing budget */
+#define VL53L0X_BUDGET_START_OVERHEAD        1910
+#define VL53L0X_BUDGET_END_OVERHEAD          960
+#define VL53L0X_BUDGET_MSRC_OVERHEAD         660
+#define VL53L0X_BUDGET_TCC_OVERHEAD          590
+#define VL53L0X_BUDGET_DSS_OVERHEAD          690
+#define VL53L0X_BUDGET_PRE_RANGE_OVERHEAD    660
+#define VL53L0X_BUDGET_FINAL_RANGE_OVERHEAD  550
+
+/* Estimativa de sigma (constantes de ajuste da API da ST) */
+#define VL53L0X_SIGMA_PULSE_WIDTH_CENTI_NS   800         // Largura efetiva do pulso
+#define VL53L0X_SIGMA_AMBIENT_WIDTH_CENTI_NS 600         // Largura efetiva da janela de ambiente
+#define VL53L0X_SIGMA_REF_INTEGRATION_MS     25          // Integração em que a referência vale 1mm
+#define VL53L0X_SIGMA_AMB_TO_SIGNAL_MAX      (0xF0000000UL / VL53L0X_SIGMA_AMBIENT_WIDTH_CENTI_NS)
+#define VL53L0X_SIGMA_RTN_MAX                0xF000      // 16.16 (m)
+#define VL53L0X_SPEED_OF_LIGHT_IN_AIR        2997        // µm por 0.1ns
+
+/* Execução de tabelas de registradores */
+#define VL53L0X_REG_PAGE_SELECT              0xFF        // Seleção de página (0x00, 0x01, 0x06, 0x07)
+#define VL53L0X_PAGE_UNKNOWN                 0x100       // Página desconhecida (após reset ou escrita falha)
+#define VL53L0X_SEQUENCE_MAX_BURST           8           // Bytes por escrita com auto-incremento
+#define VL53L0X_REG_PRIVATE_ACCESS           0x80        // != 0 abre o acesso privado (stop variable, NVM)
+#define VL53L0X_PRIVATE_ACCESS_80            0x01        // 0x80 escrito com valor != 0
+#define VL53L0X_PRIVATE_ACCESS_PAGE1         0x02        // 0x00 da página 1 escrito com 0
+#define VL53L0X_PRIVATE_ACCESS_UNKNOWN       (VL53L0X_PRIVATE_ACCESS_80 | VL53L0X_PRIVATE_ACCESS_PAGE1)
+
+/* Register sequences */
+/* I2C em standard mode, seguido da abertura da stop variable */
+static const VL53L0X_RegValue data_init_open[] = {
+    {0x88, 0x00}, {0x80, 0x01}, {0xFF, 0x01}, {0x00, 0x00}
+};
+
+static const VL53L0X_RegValue stop_variable_open[] = {
+    {0x80, 0x01}, {0xFF, 0x01}, {0x00, 0x00}
+};
+
+static const VL53L0X_RegValue stop_variable_close[] = {
+    {0x00, 0x01}, {0xFF, 0x00}, {0x80, 0x00}
+};
+
+static const VL53L0X_RegValue stop_continuous_seq[] = {
+    {0xFF, 0x01}, {0x00, 0x00}, {0x91, 0x00}, {0x00, 0x01}, {0xFF, 0x00}
+};
+
+static const VL53L0X_RegValue spad_info_open[] = {
+    {0x80, 0x01}, {0xFF, 0x01}, {0x00, 0x00}, {0xFF, 0x06}
+};
+
+static const VL53L0X_RegValue spad_info_request[] = {
+    {0xFF, 0x07}, {0x81, 0x01}, {0x80, 0x01}, {0x94, 0x6B}, {0x83, 0x00}
+};
+
+static const VL53L0X_RegValue spad_info_close[] = {
+    {0xFF, 0x01}, {0x00, 0x01}, {0xFF, 0x00}, {0x80, 0x00}
+};
+
+static const VL53L0X_RegValue ref_calibration_open[] = {
+    {0xFF, 0x01}, {0x00, 0x00}, {0xFF, 0x00}
+};
+
+static const VL53L0X_RegValue ref_calibration_close[] = {
+    {0xFF, 0x01}, {0x00, 0x01}, {0xFF, 0x00}
+};
+
+static const VL53L0X_RegValue ref_spad_setup[] = {
+    {0xFF, 0x01},
+    {VL53L0X_REG_DYNAMIC_SPAD_NUM_REQUESTED_REF_SPAD, 0x2C},
+    {VL53L0X_REG_DYNAMIC_SPAD_REF_EN_START_OFFSET, 0x00},
+    {0xFF, 0x00},
+    {VL53L0X_REG_GLOBAL_CONFIG_REF_EN_START_SELECT, 0xB4}
+};
+
+/* DefaultTuningSettings da API da ST (vl53l0x_tuning.h) */
+static const VL53L0X_RegValue default_tuning_settings[] = {
+    {0xFF, 0x01}, {0x00, 0x00},
+    {0xFF, 0x00}, {0x09, 0x00}, {0x10, 0x00}, {0x11, 0x00},
+    {0x24, 0x01}, {0x25, 0xFF}, {0x75, 0x00},
+    {0xFF, 0x01}, {0x4E, 0x2C}, {0x48, 0x00}, {0x30, 0x20},
+    {0xFF, 0x00}, {0x30, 0x09}, {0x54, 0x00}, {0x31, 0x04},
+    {0x32, 0x03}, {0x40, 0x83}, {0x46, 0x25}, {0x60, 0x00},
+    {0x27, 0x00}, {0x50, 0x06}, {0x51, 0x00}, {0x52, 0x96},
+    {0x56, 0x08}, {0x57, 0x30}, {0x61, 0x00}, {0x62, 0x00},
+    {0x64, 0x00}, {0x65, 0x00}, {0x66, 0xA0},
+    {0xFF, 0x01}, {0x22, 0x32}, {0x47, 0x14}, {0x49, 0xFF},
+    {0x4A, 0x00},
+    {0xFF, 0x00}, {0x7A, 0x0A}, {0x7B, 0x00}, {0x78, 0x21},
+    {0xFF, 0x01}, {0x23, 0x34}, {0x42, 0x00}, {0x44, 0xFF},
+    {0x45, 0x26}, {0x46, 0x05}, {0x40, 0x40}, {0x0E, 0x06},
+    {0x20, 0x1A}, {0x43, 0x40},
+    {0xFF, 0x00}, {0x34, 0x03}, {0x35, 0x44},
+    {0xFF, 0x01}, {0x31, 0x04}, {0x4B, 0x09}, {0x4C, 0x05},
+    {0x4D, 0x04},
+    {0xFF, 0x00}, {0x44, 0x00}, {0x45, 0x20}, {0x47, 0x08},
+    {0x48, 0x28}, {0x67, 0x00}, {0x70, 0x04}, {0x71, 0x01},
+    {0x72, 0xFE}, {0x76, 0x00}, {0x77, 0x00},
+    {0xFF, 0x01}, {0x0D, 0x01},
+    {0xFF, 0x00}, {0x80, 0x01}, {0x01, 0xF8},
+    {0xFF, 0x01}, {0x8E, 0x01}, {0x00, 0x01}, {0xFF, 0x00},
+    {0x80, 0x00}
+};
+
+/* Registradores da página 0 mantidos em RAM: só configuração escrita pelo
+   host ou constante, nunca resultados, comandos ou registradores com efeito
+   colateral. Em ordem crescente; a soma de count é VL53L0X_SHADOW_SIZE */
+static const VL53L0X_ShadowRange shadow_ranges[] = {
+    {VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, 1},
+    {VL53L0X_REG_SYSTEM_INTERMEASUREMENT_PERIOD, 4},
+    {VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG_GPIO, 1},
+    {VL53L0X_REG_SYSTEM_THRESH_HIGH, 4},                 // THRESH_HIGH e THRESH_LOW
+    {VL53L0X_REG_ALGO_PART_TO_PART_RANGE_OFFSET_MM, 2},
+    {VL53L0X_REG_ALGO_PHASECAL_CONFIG_TIMEOUT, 1},
+    {VL53L0X_REG_GLOBAL_CONFIG_VCSEL_WIDTH, 1},
+    {VL53L0X_REG_FINAL_RANGE_CONFIG_MIN_COUNT_RATE_RTN_LIMIT, 5},    // Até FINAL_RANGE_VALID_PHASE_HIGH
+    {VL53L0X_REG_PRE_RANGE_CONFIG_VCSEL_PERIOD, 3},      // Período e timeout do pre-range
+    {VL53L0X_REG_PRE_RANGE_CONFIG_VALID_PHASE_LOW, 2},
+    {VL53L0X_REG_MSRC_CONFIG_CONTROL, 1},
+    {VL53L0X_REG_FINAL_RANGE_CONFIG_VCSEL_PERIOD, 3},    // Período e timeout do final range
+    {VL53L0X_REG_GPIO_HV_MUX_ACTIVE_HIGH, 1},
+    {VL53L0X_REG_VHV_CONFIG_PAD_SCL_SDA_EXTSUP_HV, 1},
+    {VL53L0X_REG_GLOBAL_CONFIG_SPAD_ENABLES_REF_0, 7},   // Mapa de SPADs e REF_EN_START_SELECT
+    {VL53L0X_REG_OSC_CALIBRATE_VAL, 2}
+};
+
+/* Perfis de medição, na ordem de VL53L0X_ProfileId */
+static const VL53L0X_Profile profiles[VL53L0X_PROFILE_COUNT] = {
+    /* nome, budget (µs), período (ms), VCSEL pre/final (PCLKs), sinal (MCPS 9.7), sigma (mm), leituras, salto (mm) */
+    {"precisao",   500000, 500, VL53L0X_PRE_RANGE_VCSEL_PERIOD_DEFAULT, VL53L0X_FINAL_RANGE_VCSEL_PERIOD_DEFAULT,
+     VL53L0X_FP97(0.30), 18, 5, 50},
+    {"balanceada", VL53L0X_HIGH_ACCURACY_TIMING_BUDGET, 200, VL53L0X_PRE_RANGE_VCSEL_PERIOD_DEFAULT, VL53L0X_FINAL_RANGE_VCSEL_PERIOD_DEFAULT,
+     VL53L0X_SIGNAL_RATE_LIMIT, VL53L0X_SIGMA_LIMIT, VL53L0X_VALID_READS_BEFORE_UPDATE, VL53L0X_MAX_MEASUREMENT_JUMP},
+    {"rapida",     50000, 50, VL53L0X_PRE_RANGE_VCSEL_PERIOD_DEFAULT, VL53L0X_FINAL_RANGE_VCSEL_PERIOD_DEFAULT,
+     VL53L0X_FP97(0.20), 32, 2, 200},
+    {"veloz",      VL53L0X_MIN_TIMING_BUDGET, 20, VL53L0X_PRE_RANGE_VCSEL_PERIOD_DEFAULT, VL53L0X_FINAL_RANGE_VCSEL_PERIOD_DEFAULT,
+     VL53L0X_FP97(0.25), 32, 1, 300},
+    {"longo",      33000, 40, VL53L0X_PRE_RANGE_VCSEL_PERIOD_MAX, VL53L0X_FINAL_RANGE_VCSEL_PERIOD_MAX,
+     VL53L0X_FP97(0.10), 60, 3, 100}
+};
+
+/* Fase válida do pre-range por período de VCSEL (12, 14, 16, 18 PCLKs) */
+static const uint8_t pre_range_valid_phase_high[] = {0x18, 0x30, 0x40, 0x50};
+
+/* Ajustes do final range por período de VCSEL (8, 10, 12, 14 PCLKs) */
+static const VL53L0X_FinalRangeVcselConfig final_range_vcsel_config[] = {
+    {0x10, 0x02, 0x0C, 0x30},
+    {0x28, 0x03, 0x09, 0x20},
+    {0x38, 0x03, 0x08, 0x20},
+    {0x48, 0x03, 0x07, 0x20}
+};
+
+/* Código de erro do dispositivo (RESULT_RANGE_STATUS bits 6:3) -> status, como na API da ST */
+static const uint8_t device_status_map[16] = {
+    VL53L0X_RANGE_VALID,             // 0  Sem erro
+    VL53L0X_RANGE_HARDWARE_FAIL,     // 1  Continuidade do VCSEL
+    VL53L0X_RANGE_HARDWARE_FAIL,     // 2  Watchdog do VCSEL
+    VL53L0X_RANGE_HARDWARE_FAIL,     // 3  VHV não encontrado
+    VL53L0X_RANGE_SIGNAL_FAIL,       // 4  MSRC sem alvo
+    VL53L0X_RANGE_SIGMA_FAIL,        // 5  SNR
+    VL53L0X_RANGE_PHASE_FAIL,        // 6  Fase da medição
+    VL53L0X_RANGE_SIGMA_FAIL,        // 7  Limiar de sigma
+    VL53L0X_RANGE_MIN_RANGE_FAIL,    // 8  TCC
+    VL53L0X_RANGE_PHASE_FAIL,        // 9  Consistência de fase
+    VL53L0X_RANGE_MIN_RANGE_FAIL,    // 10 Min clip
+    VL53L0X_RANGE_VALID,             // 11 Medição completa
+    VL53L0X_RANGE_WRAP_AROUND,       // 12 Underflow do algoritmo
+    VL53L0X_RANGE_WRAP_AROUND,       // 13 Overflow do algoritmo
+    VL53L0X_RANGE_SIGNAL_FAIL,       // 14 Range ignore threshold
+    VL53L0X_RANGE_HARDWARE_FAIL      // 15 Reservado
+};
+
+/* Política default por status */
+static const uint8_t default_status_policy[VL53L0X_RANGE_STATUS_COUNT] = {
+    VL53L0X_POLICY_ACCEPT_FLAGGED,   // Válido (sempre aceito, sem marca)
+    VL53L0X_POLICY_ACCEPT_FLAGGED,   // Sigma: distância utilizável, só menos precisa
+    VL53L0X_POLICY_DROP,             // Sinal
+    VL53L0X_POLICY_DROP,             // Alcance mínimo
+    VL53L0X_POLICY_RETRY,            // Fase: costuma ser transitória
+    VL53L0X_POLICY_DROP,             // Hardware
+    VL53L0X_POLICY_DROP              // Wrap-around
+};
+
+static const char *const range_status_names[VL53L0X_RANGE_STATUS_COUNT] = {
+    "valido", "sigma", "sinal", "min", "fase", "hw", "wrap"
+};
 
 /* Private function prototypes */
-static VL53L0X_Status VL53L0X_WriteReg(I2C_HandleTypeDef *hi2c, uint8_t reg, uint8_t value);
-static VL53L0X_Status VL53L0X_ReadReg(I2C_HandleTypeDef *hi2c, uint8_t reg, uint8_t *value);
-static VL53L0X_Status VL53L0X_ReadMulti(I2C_HandleTypeDef *hi2c, uint8_t reg, uint8_t *data, uint8_t count);
-static bool VL53L0X_IsValidReading(VL53L0X_RangingData *ranging_data);
+static VL53L0X_Status VL53L0X_WriteReg(VL53L0X_Dev *dev, uint8_t reg, uint8_t value);
+static VL53L0X_Status VL53L0X_ReadReg(VL53L0X_Dev *dev, uint8_t reg, uint8_t *value);
+static VL53L0X_Status VL53L0X_ReadMulti(VL53L0X_Dev *dev, uint8_t reg, uint8_t *data, uint8_t count);
+static VL53L0X_Status VL53L0X_WriteMulti(VL53L0X_Dev *dev, uint8_t reg, const uint8_t *data, uint8_t count);
+static VL53L0X_Status VL53L0X_WriteReg16(VL53L0X_Dev *dev, uint8_t reg, uint16_t value);
+static VL53L0X_Status VL53L0X_ReadReg16(VL53L0X_Dev *dev, uint8_t reg, uint16_t *value);
+static VL53L0X_Status VL53L0X_WriteReg32(VL53L0X_Dev *dev, uint8_t reg, uint32_t value);
+static VL53L0X_Status VL53L0X_WriteSequence(VL53L0X_Dev *dev, const VL53L0X_RegValue *seq, uint16_t count);
+static VL53L0X_Status VL53L0X_WriteStopVariable(VL53L0X_Dev *dev);
+static VL53L0X_Status VL53L0X_InitInternal(VL53L0X_Dev *dev, const VL53L0X_Calibration *calib);
+static VL53L0X_Status VL53L0X_WaitBoot(VL53L0X_Dev *dev);
+static VL53L0X_Status VL53L0X_ReadRefCalibration(VL53L0X_Dev *dev, uint8_t *vhv_settings, uint8_t *phase_cal);
+static VL53L0X_Status VL53L0X_WriteRefCalibration(VL53L0X_Dev *dev, uint8_t vhv_settings, uint8_t phase_cal);
+static VL53L0X_Status VL53L0X_GetSpadInfo(VL53L0X_Dev *dev, uint8_t *count, bool *type_is_aperture);
+static VL53L0X_Status VL53L0X_PerformSingleRefCalibration(VL53L0X_Dev *dev, uint8_t vhv_init_byte);
+static VL53L0X_Status VL53L0X_GetSequenceStepEnables(VL53L0X_Dev *dev, VL53L0X_SequenceStepEnables *enables);
+static VL53L0X_Status VL53L0X_GetSequenceStepTimeouts(VL53L0X_Dev *dev, const VL53L0X_SequenceStepEnables *enables,
+                                                      VL53L0X_SequenceStepTimeouts *timeouts);
+static VL53L0X_Status VL53L0X_ReadTimingBudget(VL53L0X_Dev *dev, uint32_t *budget_us);
+static uint16_t VL53L0X_DecodeTimeout(uint16_t reg_val);
+static uint16_t VL53L0X_EncodeTimeout(uint32_t timeout_mclks);
+static uint8_t VL53L0X_DecodeVcselPeriod(uint8_t reg_val);
+static uint8_t VL53L0X_EncodeVcselPeriod(uint8_t period_pclks);
+static bool VL53L0X_IsValidReading(const VL53L0X_RangingData *ranging_data);
+static void VL53L0X_UpdateSigmaTiming(VL53L0X_Dev *dev, const VL53L0X_SequenceStepTimeouts *timeouts,
+                                      uint32_t final_range_mclks);
+static uint16_t VL53L0X_CalcSigma(VL53L0X_Dev *dev, const VL53L0X_RangingData *ranging_data);
+static uint8_t VL53L0X_DecodeRangeStatus(VL53L0X_Dev *dev, const VL53L0X_RangingData *ranging_data);
+static VL53L0X_Status VL53L0X_RetryMeasurement(VL53L0X_Dev *dev);
+static VL53L0X_Status VL53L0X_AdaptBudget(VL53L0X_Dev *dev, const VL53L0X_RangingData *ranging_data);
+static VL53L0X_Status VL53L0X_ApplyBudget(VL53L0X_Dev *dev, uint32_t budget_us);
+static void VL53L0X_ShadowReset(VL53L0X_Dev *dev);
+static void VL53L0X_FetchComplete(void *context, HAL_StatusTypeDef status);
+static int16_t VL53L0X_ShadowSlot(uint8_t reg);
+static bool VL53L0X_ShadowActive(VL53L0X_Dev *dev);
+static bool VL53L0X_ShadowMatches(VL53L0X_Dev *dev, uint8_t reg, uint8_t value);
+static void VL53L0X_ShadowWrite(VL53L0X_Dev *dev, uint8_t reg, const uint8_t *data, uint8_t count, bool written);
+static bool VL53L0X_ShadowRead(VL53L0X_Dev *dev, uint8_t reg, uint8_t *data, uint8_t count);
+static void VL53L0X_ShadowFill(VL53L0X_Dev *dev, uint8_t reg, const uint8_t *data, uint8_t count);
+
+void VL53L0X_DevInit(VL53L0X_Dev *dev, I2C_HandleTypeDef *hi2c, uint8_t address)
+{
+    memset(dev, 0, sizeof(VL53L0X_Dev));
+    dev->hi2c = hi2c;
+    dev->address = address;
+    dev->profile = &profiles[VL53L0X_PROFILE_BALANCED];
+    dev->timingBudgetUs = dev->profile->timingBudgetUs;
+    dev->mode = VL53L0X_MODE_SINGLE;
+    dev->measurementTimeout = VL53L0X_MEASUREMENT_TIMEOUT;
+    memcpy(dev->statusPolicy, default_status_policy, sizeof(dev->statusPolicy));
+    VL53L0X_ShadowReset(dev);
+    
+    /* Política original: salto máximo + leituras consecutivas do perfil */
+    RangeFilter_Init(&dev->filter);
+    RangeFilter_AddGate(&dev->filter, dev->profile->maxMeasurementJump, dev->profile->validReadsBeforeUpdate);
+}
+
+VL53L0X_Status VL53L0X_SetAddress(VL53L0X_Dev *dev, uint8_t new_address)
+{
+    /* Endereço volta a 0x29 quando o sensor passa por XSHUT ou perde alimentação */
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_I2C_SLAVE_DEVICE_ADDRESS, new_address & 0x7F) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    dev->address = new_address & 0x7F;
+    
+    return VL53L0X_OK;
+}
+
+VL53L0X_Status VL53L0X_Init(VL53L0X_Dev *dev)
+{
+    return VL53L0X_InitInternal(dev, NULL);
+}
+
+VL53L0X_Status VL53L0X_InitFromCalibration(VL53L0X_Dev *dev, const VL53L0X_Calibration *calib)
+{
+    if(calib == NULL) {
+        return VL53L0X_ERROR;
+    }
+    
+    return VL53L0X_InitInternal(dev, calib);
+}
+
+void VL53L0X_GetCalibration(VL53L0X_Dev *dev, VL53L0X_Calibration *calib)
+{
+    memcpy(calib, &dev->calibration, sizeof(VL53L0X_Calibration));
+}
+
+static VL53L0X_Status VL53L0X_InitInternal(VL53L0X_Dev *dev, const VL53L0X_Calibration *calib)
+{
+    uint8_t temp;
+    
+    /* Valores anteriores ao init não valem mais (o sensor pode ter sido reiniciado) */
+    VL53L0X_ShadowReset(dev);
+    
+    /* Aguarda o boot consultando o model ID, em vez de um atraso fixo */
+    if(VL53L0X_WaitBoot(dev) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* ---- Data init ---- */
+    
+#if VL53L0X_IO_2V8
+    /* I/O em 2V8 */
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_VHV_CONFIG_PAD_SCL_SDA_EXTSUP_HV, &temp) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_VHV_CONFIG_PAD_SCL_SDA_EXTSUP_HV, temp | 0x01) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+#endif
+    
+    /* I2C standard mode e captura da stop variable, necessária para iniciar cada medição */
+    if(VL53L0X_WriteSequence(dev, data_init_open, sizeof(data_init_open) / sizeof(data_init_open[0])) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_ReadReg(dev, 0x91, &dev->stopVariable) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteSequence(dev, stop_variable_close, sizeof(stop_variable_close) / sizeof(stop_variable_close[0])) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Desabilita os limit checks SIGNAL_RATE_MSRC (bit 1) e SIGNAL_RATE_PRE_RANGE (bit 4) */
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_MSRC_CONFIG_CONTROL, &temp) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_MSRC_CONFIG_CONTROL, temp | 0x12) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    if(VL53L0X_SetSignalRateLimit(dev, VL53L0X_SIGNAL_RATE_LIMIT) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, 0xFF) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* ---- Static init: reference SPAD management ---- */
+    
+    if(calib != NULL) {
+        /* Mapa já filtrado na calibração original */
+        memcpy(&dev->calibration, calib, sizeof(VL53L0X_Calibration));
+        if(VL53L0X_WriteSequence(dev, ref_spad_setup, sizeof(ref_spad_setup) / sizeof(ref_spad_setup[0])) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    } else {
+        bool spad_type_is_aperture;
+    
+        if(VL53L0X_GetSpadInfo(dev, &dev->calibration.spadCount, &spad_type_is_aperture) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        dev->calibration.spadTypeIsAperture = spad_type_is_aperture;
+    
+        /* O mapa de SPADs de referência vem do NVM; habilita apenas os SPADs indicados */
+        if(VL53L0X_ReadMulti(dev, VL53L0X_REG_GLOBAL_CONFIG_SPAD_ENABLES_REF_0, dev->calibration.refSpadMap, 6) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        if(VL53L0X_WriteSequence(dev, ref_spad_setup, sizeof(ref_spad_setup) / sizeof(ref_spad_setup[0])) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    
+        /* SPADs de abertura começam no índice 12 */
+        uint8_t first_spad_to_enable = spad_type_is_aperture ? 12 : 0;
+        uint8_t spads_enabled = 0;
+        for(uint8_t i = 0; i < 48; i++) {
+            if(i < first_spad_to_enable || spads_enabled == dev->calibration.spadCount) {
+                dev->calibration.refSpadMap[i / 8] &= ~(1 << (i % 8));
+            } else if((dev->calibration.refSpadMap[i / 8] >> (i % 8)) & 0x01) {
+                spads_enabled++;
+            }
+        }
+    }
+    if(VL53L0X_WriteMulti(dev, VL53L0X_REG_GLOBAL_CONFIG_SPAD_ENABLES_REF_0, dev->calibration.refSpadMap, 6) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* ---- Static init: default tuning settings ---- */
+    
+    if(VL53L0X_WriteSequence(dev, default_tuning_settings, sizeof(default_tuning_settings) / sizeof(default_tuning_settings[0])) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Set GPIO config to interrupt on new sample ready */
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG_GPIO, VL53L0X_GPIO_FUNC_NEW_SAMPLE_READY) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    dev->thresholdMode = VL53L0X_THRESHOLD_OFF;
+    
+    /* GPIO1 ativo baixo (bit 4 em zero): a linha tem pull-up e gera borda de descida na EXTI */
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_GPIO_HV_MUX_ACTIVE_HIGH, &temp) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_GPIO_HV_MUX_ACTIVE_HIGH, temp & ~0x10) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Lê o budget padrão do sensor e reprograma com MSRC e TCC desligados */
+    if(VL53L0X_ReadTimingBudget(dev, &dev->timingBudgetUs) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, VL53L0X_SEQUENCE_DEFAULT) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_SetMeasurementTimingBudget(dev, dev->timingBudgetUs) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* ---- Reference calibration (VHV e fase) ---- */
+    
+    if(calib != NULL) {
+        if(VL53L0X_WriteRefCalibration(dev, calib->vhvSettings, calib->phaseCal) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        if(VL53L0X_WriteReg16(dev, VL53L0X_REG_ALGO_PART_TO_PART_RANGE_OFFSET_MM, calib->offset) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    } else {
+        if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, 0x01) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        if(VL53L0X_PerformSingleRefCalibration(dev, 0x40) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    
+        if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, 0x02) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        if(VL53L0X_PerformSingleRefCalibration(dev, 0x00) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    
+        /* Guarda os resultados para um boot rápido posterior */
+        if(VL53L0X_ReadRefCalibration(dev, &dev->calibration.vhvSettings, &dev->calibration.phaseCal) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        if(VL53L0X_ReadReg16(dev, VL53L0X_REG_ALGO_PART_TO_PART_RANGE_OFFSET_MM, &dev->calibration.offset) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    }
+    
+    /* Restaura a sequência de medição */
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, VL53L0X_SEQUENCE_DEFAULT) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Libera a linha GPIO1 para a primeira medição */
+    dev->dataReady = false;
+    
+    return VL53L0X_OK;
+}
+
+const VL53L0X_Profile *VL53L0X_GetProfile(VL53L0X_ProfileId id)
+{
+    if(id >= VL53L0X_PROFILE_COUNT) {
+        return NULL;
+    }
+    
+    return &profiles[id];
+}
+
+const VL53L0X_Profile *VL53L0X_FindProfile(const char *name)
+{
+    for(uint8_t i = 0; i < VL53L0X_PROFILE_COUNT; i++) {
+        if(strcmp(profiles[i].name, name) == 0) {
+            return &profiles[i];
+        }
+    }
+    
+    return NULL;
+}
+
+VL53L0X_Status VL53L0X_SetProfile(VL53L0X_Dev *dev, const VL53L0X_Profile *profile)
+{
+    if(profile == NULL) {
+        return VL53L0X_ERROR;
+    }
+    
+    if(VL53L0X_SetSignalRateLimit(dev, profile->signalRateLimit) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Budget antes dos períodos: cada troca de VCSEL reaplica o budget atual */
+    if(VL53L0X_SetMeasurementTimingBudget(dev, profile->timingBudgetUs) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_SetVcselPulsePeriod(dev, VL53L0X_VCSEL_PERIOD_PRE_RANGE, profile->preRangeVcselPeriod) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_SetVcselPulsePeriod(dev, VL53L0X_VCSEL_PERIOD_FINAL_RANGE, profile->finalRangeVcselPeriod) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Novos limites de validação: reinicia o filtro de leituras */
+    dev->profile = profile;
+    RangeFilter_SetGate(&dev->filter, profile->maxMeasurementJump, profile->validReadsBeforeUpdate);
+    RangeFilter_Reset(&dev->filter);
+    
+    /* Budget adaptativo recomeça do budget do perfil */
+    dev->adaptiveSigmaSum = 0;
+    dev->adaptiveSamples = 0;
+    
+    return VL53L0X_OK;
+}
+
+const VL53L0X_Profile *VL53L0X_GetActiveProfile(VL53L0X_Dev *dev)
+{
+    return dev->profile;
+}
+
+VL53L0X_Status VL53L0X_SetMeasurementTimingBudget(VL53L0X_Dev *dev, uint32_t budget_us)
+{
+    VL53L0X_SequenceStepEnables enables;
+    VL53L0X_SequenceStepTimeouts timeouts;
+    uint32_t used_budget_us = VL53L0X_BUDGET_START_OVERHEAD + VL53L0X_BUDGET_END_OVERHEAD;
+    
+    /* Acima do máximo o timeout do final range não cabe no registrador codificado */
+    if(budget_us < VL53L0X_MIN_TIMING_BUDGET || budget_us > VL53L0X_MAX_TIMING_BUDGET) {
+        return VL53L0X_ERROR;
+    }
+    
+    if(VL53L0X_GetSequenceStepEnables(dev, &enables) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_GetSequenceStepTimeouts(dev, &enables, &timeouts) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    if(enables.tcc) {
+        used_budget_us += timeouts.msrc_dss_tcc_us + VL53L0X_BUDGET_TCC_OVERHEAD;
+    }
+    
+    if(enables.dss) {
+        used_budget_us += 2 * (timeouts.msrc_dss_tcc_us + VL53L0X_BUDGET_DSS_OVERHEAD);
+    } else if(enables.msrc) {
+        used_budget_us += timeouts.msrc_dss_tcc_us + VL53L0X_BUDGET_MSRC_OVERHEAD;
+    }
+    
+    if(enables.pre_range) {
+        used_budget_us += timeouts.pre_range_us + VL53L0X_BUDGET_PRE_RANGE_OVERHEAD;
+    }
+    
+    if(enables.final_range) {
+        used_budget_us += VL53L0X_BUDGET_FINAL_RANGE_OVERHEAD;
+    
+        /* O tempo restante do budget vai para o final range */
+        if(used_budget_us > budget_us) {
+            return VL53L0X_ERROR;
+        }
+    
+        uint32_t final_range_timeout_us = budget_us - used_budget_us;
+        uint32_t final_range_timeout_mclks =
+            VL53L0X_TimeoutMicrosecondsToMclks(final_range_timeout_us, timeouts.final_range_vcsel_period_pclks);
+    
+        /* O timeout do final range inclui o do pre-range */
+        if(enables.pre_range) {
+            final_range_timeout_mclks += timeouts.pre_range_mclks;
+        }
+    
+        if(VL53L0X_WriteReg16(dev, VL53L0X_REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI,
+                              VL53L0X_EncodeTimeout(final_range_timeout_mclks)) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    
+        /* Termos da sigma dependem só da temporização: calculados aqui, não por amostra */
+        VL53L0X_UpdateSigmaTiming(dev, &timeouts,
+                                  final_range_timeout_mclks - (enables.pre_range ? timeouts.pre_range_mclks : 0));
+    }
+    
+    dev->timingBudgetUs = budget_us;
+    
+    return VL53L0X_OK;
+}
+
+uint32_t VL53L0X_GetMeasurementTimingBudget(VL53L0X_Dev *dev)
+{
+    return dev->timingBudgetUs;
+}
+
+VL53L0X_Status VL53L0X_SetSignalRateLimit(VL53L0X_Dev *dev, VL53L0X_FixPt97 limit_mcps)
+{
+    /* O registrador já usa o formato 9.7 */
+    return VL53L0X_WriteReg16(dev, VL53L0X_REG_FINAL_RANGE_CONFIG_MIN_COUNT_RATE_RTN_LIMIT, limit_mcps);
+}
+
+VL53L0X_Status VL53L0X_SetVcselPulsePeriod(VL53L0X_Dev *dev, VL53L0X_VcselPeriodType type, uint8_t period_pclks)
+{
+    VL53L0X_SequenceStepEnables enables;
+    VL53L0X_SequenceStepTimeouts timeouts;
+    uint8_t vcsel_period_reg = VL53L0X_EncodeVcselPeriod(period_pclks);
+    uint8_t sequence_config;
+    
+    if(period_pclks & 0x01) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Timeouts atuais em µs, reconvertidos para MCLKs com o novo período */
+    if(VL53L0X_GetSequenceStepEnables(dev, &enables) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_GetSequenceStepTimeouts(dev, &enables, &timeouts) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    if(type == VL53L0X_VCSEL_PERIOD_PRE_RANGE) {
+        if(period_pclks < VL53L0X_PRE_RANGE_VCSEL_PERIOD_MIN || period_pclks > VL53L0X_PRE_RANGE_VCSEL_PERIOD_MAX) {
+            return VL53L0X_ERROR;
+        }
+    
+        /* Fase válida em ordem crescente: LOW/HIGH vão em uma única escrita */
+        const VL53L0X_RegValue pre_range_seq[] = {
+            {VL53L0X_REG_PRE_RANGE_CONFIG_VALID_PHASE_LOW, 0x08},
+            {VL53L0X_REG_PRE_RANGE_CONFIG_VALID_PHASE_HIGH,
+             pre_range_valid_phase_high[(period_pclks - VL53L0X_PRE_RANGE_VCSEL_PERIOD_MIN) / 2]},
+            {VL53L0X_REG_PRE_RANGE_CONFIG_VCSEL_PERIOD, vcsel_period_reg}
+        };
+        if(VL53L0X_WriteSequence(dev, pre_range_seq, sizeof(pre_range_seq) / sizeof(pre_range_seq[0])) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    
+        uint32_t pre_range_mclks = VL53L0X_TimeoutMicrosecondsToMclks(timeouts.pre_range_us, period_pclks);
+        if(VL53L0X_WriteReg16(dev, VL53L0X_REG_PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI,
+                              VL53L0X_EncodeTimeout(pre_range_mclks)) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    
+        /* O timeout do MSRC também é contado em MCLKs do pre-range */
+        uint32_t msrc_mclks = VL53L0X_TimeoutMicrosecondsToMclks(timeouts.msrc_dss_tcc_us, period_pclks);
+        if(VL53L0X_WriteReg(dev, VL53L0X_REG_MSRC_CONFIG_TIMEOUT_MACROP,
+                            (msrc_mclks > 256) ? 255 : (uint8_t)(msrc_mclks - 1)) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    } else if(type == VL53L0X_VCSEL_PERIOD_FINAL_RANGE) {
+        if(period_pclks < VL53L0X_FINAL_RANGE_VCSEL_PERIOD_MIN || period_pclks > VL53L0X_FINAL_RANGE_VCSEL_PERIOD_MAX) {
+            return VL53L0X_ERROR;
+        }
+    
+        const VL53L0X_FinalRangeVcselConfig *config =
+            &final_range_vcsel_config[(period_pclks - VL53L0X_FINAL_RANGE_VCSEL_PERIOD_MIN) / 2];
+        const VL53L0X_RegValue final_range_seq[] = {
+            {VL53L0X_REG_FINAL_RANGE_CONFIG_VALID_PHASE_LOW, 0x08},
+            {VL53L0X_REG_FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, config->valid_phase_high},
+            {VL53L0X_REG_GLOBAL_CONFIG_VCSEL_WIDTH, config->vcsel_width},
+            {VL53L0X_REG_ALGO_PHASECAL_CONFIG_TIMEOUT, config->phasecal_timeout},
+            {0xFF, 0x01}, {VL53L0X_REG_ALGO_PHASECAL_LIM, config->phasecal_lim}, {0xFF, 0x00},
+            {VL53L0X_REG_FINAL_RANGE_CONFIG_VCSEL_PERIOD, vcsel_period_reg}
+        };
+        if(VL53L0X_WriteSequence(dev, final_range_seq, sizeof(final_range_seq) / sizeof(final_range_seq[0])) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    
+        /* O timeout do final range inclui o do pre-range */
+        uint32_t final_range_mclks = VL53L0X_TimeoutMicrosecondsToMclks(timeouts.final_range_us, period_pclks);
+        if(enables.pre_range) {
+            final_range_mclks += timeouts.pre_range_mclks;
+        }
+        if(VL53L0X_WriteReg16(dev, VL53L0X_REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI,
+                              VL53L0X_EncodeTimeout(final_range_mclks)) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    } else {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Redistribui o budget com os novos períodos */
+    if(VL53L0X_SetMeasurementTimingBudget(dev, dev->timingBudgetUs) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* A calibração de fase depende do período: refaz apenas ela */
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, &sequence_config) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, 0x02) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_PerformSingleRefCalibration(dev, 0x00) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, sequence_config) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* A calibração também aciona GPIO1 */
+    dev->dataReady = false;
+    
+    return VL53L0X_OK;
+}
+
+VL53L0X_Status VL53L0X_StartContinuous(VL53L0X_Dev *dev, uint32_t period_ms)
+{
+    uint16_t osc_calibrate_val;
+    
+    if(VL53L0X_WriteStopVariable(dev) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Interrupção que ficou ativa (leitura perdida, p.ex. com o barramento
+       travado) mantém GPIO1 baixo e nenhuma nova borda chegaria */
+    dev->dataReady = false;
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    if(period_ms != 0) {
+        /* O período intermedição é contado em ciclos do oscilador interno */
+        if(VL53L0X_ReadReg16(dev, VL53L0X_REG_OSC_CALIBRATE_VAL, &osc_calibrate_val) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        uint32_t period = period_ms;
+        if(osc_calibrate_val != 0) {
+            period *= osc_calibrate_val;
+        }
+    
+        if(VL53L0X_WriteReg32(dev, VL53L0X_REG_SYSTEM_INTERMEASUREMENT_PERIOD, period) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    
+        if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSRANGE_START, VL53L0X_SYSRANGE_MODE_TIMED) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        dev->mode = VL53L0X_MODE_TIMED;
+        dev->measurementPeriodMs = period_ms;
+    } else {
+        if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSRANGE_START, VL53L0X_SYSRANGE_MODE_BACKTOBACK) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        dev->mode = VL53L0X_MODE_CONTINUOUS;
+        dev->measurementPeriodMs = 0;
+    }
+    
+    dev->measurementPending = true;
+    dev->measurementStartTick = HAL_GetTick();
+    
+    return VL53L0X_OK;
+}
+
+VL53L0X_Status VL53L0X_StopContinuous(VL53L0X_Dev *dev)
+{
+    /* Escrever single-shot encerra a sequência contínua após a medição atual */
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSRANGE_START, VL53L0X_SYSRANGE_MODE_SINGLESHOT) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteSequence(dev, stop_continuous_seq, sizeof(stop_continuous_seq) / sizeof(stop_continuous_seq[0])) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    dev->mode = VL53L0X_MODE_SINGLE;
+    dev->measurementPending = false;
+    dev->measurementPeriodMs = 0;
+    
+    return VL53L0X_OK;
+}
+
+VL53L0X_RangingMode VL53L0X_GetRangingMode(VL53L0X_Dev *dev)
+{
+    return dev->mode;
+}
+
+void VL53L0X_DataReadyCallback(VL53L0X_Dev *dev)
+{
+    dev->dataReadyTick = HAL_GetTick();
+    dev->dataReady = true;
+}
+
+bool VL53L0X_IsDataReady(VL53L0X_Dev *dev)
+{
+    return dev->dataReady;
+}
+
+void VL53L0X_SetMeasurementTimeout(VL53L0X_Dev *dev, uint32_t timeout_ticks)
+{
+    dev->measurementTimeout = timeout_ticks;
+}
+
+VL53L0X_Status VL53L0X_StartMeasurement(VL53L0X_Dev *dev)
+{
+    if(dev->mode == VL53L0X_MODE_SINGLE) {
+        /* Start single range measurement */
+        dev->dataReady = false;
+        if(VL53L0X_WriteStopVariable(dev) != VL53L0X_OK) {
+            dev->measurementPending = false;
+            return VL53L0X_ERROR;
+        }
+        if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSRANGE_START, VL53L0X_SYSRANGE_MODE_SINGLESHOT) != VL53L0X_OK) {
+            dev->measurementPending = false;
+            return VL53L0X_ERROR;
+        }
+    }
+    
+    /* Em modo contínuo apenas rearma o prazo para a próxima amostra */
+    dev->measurementPending = true;
+    dev->measurementStartTick = HAL_GetTick();
+    
+    return VL53L0X_OK;
+}
+
+VL53L0X_MeasState VL53L0X_PollMeasurement(VL53L0X_Dev *dev)
+{
+    /* Bloco lido por DMA vale só para a amostra sinalizada (parada e
+       reconfiguração descartam dataReady) */
+    if(dev->fetchState == VL53L0X_FETCH_DONE || dev->fetchState == VL53L0X_FETCH_FAILED) {
+        if(dev->dataReady) {
+            return VL53L0X_MEAS_READY;
+        }
+        dev->fetchState = VL53L0X_FETCH_IDLE;
+    }
+    
+    if(dev->fetchState == VL53L0X_FETCH_BUSY) {
+        /* Leitura na fila: o i2c_bus a inicia quando o barramento libera e
+           recupera uma transferência presa (a conclusão marca FAILED) */
+        I2CBus_Process(dev->hi2c);
+        return VL53L0X_MEAS_BUSY;
+    }
+    
+    if(dev->dataReady) {
+        /* Lê o bloco de resultado por DMA, à frente do tráfego de configuração e
+           varredura; o loop segue livre até a conclusão */
+        dev->fetchState = VL53L0X_FETCH_BUSY;
+        switch(I2CBus_ReadAsync(dev->hi2c, I2C_BUS_PRIORITY_HIGH, dev->address, VL53L0X_REG_RESULT_RANGE_STATUS,
+                                dev->resultBlock, VL53L0X_RESULT_BLOCK_SIZE, VL53L0X_FetchComplete, dev)) {
+            case HAL_OK:
+                return VL53L0X_MEAS_BUSY;
+            case HAL_BUSY:
+                /* Fila do barramento cheia: tenta na próxima chamada */
+                dev->fetchState = VL53L0X_FETCH_IDLE;
+                return VL53L0X_MEAS_BUSY;
+            default:
+                /* Sem transporte assíncrono: VL53L0X_FetchMeasurement lê direto */
+                dev->fetchState = VL53L0X_FETCH_IDLE;
+                return VL53L0X_MEAS_READY;
+        }
+    }
+    
+    if(!dev->measurementPending) {
+        return VL53L0X_MEAS_IDLE;
+    }
+    
+    /* Prazo = duração esperada (budget ou período, o maior) + margem */
+    uint32_t expected_ms = dev->timingBudgetUs / 1000;
+    if(dev->measurementPeriodMs > expected_ms) {
+        expected_ms = dev->measurementPeriodMs;
+    }
+    
+    /* Em modo de limiar o sensor só sinaliza amostras dentro da condição:
+       a ausência de GPIO1 não indica falha */
+    if(dev->thresholdMode != VL53L0X_THRESHOLD_OFF) {
+        return VL53L0X_MEAS_BUSY;
+    }
+    
+    if(HAL_GetTick() - dev->measurementStartTick >= expected_ms + dev->measurementTimeout) {
+        dev->measurementPending = false;
+        return VL53L0X_MEAS_TIMEOUT;
+    }
+    
+    return VL53L0X_MEAS_BUSY;
+}
+
+VL53L0X_Status VL53L0X_FetchMeasurement(VL53L0X_Dev *dev, VL53L0X_RangingData *ranging_data)
+{
+    uint8_t data[VL53L0X_RESULT_BLOCK_SIZE];
+    uint8_t policy;
+    bool was_retry = dev->retryPending;
+    VL53L0X_FetchState fetch_state;
+    
+    if(!dev->dataReady) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Leitura por DMA ainda em andamento: aguarda a conclusão */
+    if(dev->fetchState == VL53L0X_FETCH_BUSY) {
+        I2CBus_WaitIdle(dev->hi2c, VL53L0X_I2C_TIMEOUT);
+    }
+    fetch_state = dev->fetchState;
+    dev->fetchState = VL53L0X_FETCH_IDLE;
+    
+    dev->dataReady = false;
+    dev->retryPending = false;
+    ranging_data->timestamp = dev->dataReadyTick;
+    
+    /* Em modo contínuo a próxima amostra já está em andamento */
+    dev->measurementPending = (dev->mode != VL53L0X_MODE_SINGLE);
+    dev->measurementStartTick = HAL_GetTick();
+    
+    /* Status, taxas e distância em uma única transação: já lidos por DMA ou lidos agora */
+    if(fetch_state == VL53L0X_FETCH_DONE) {
+        memcpy(data, dev->resultBlock, VL53L0X_RESULT_BLOCK_SIZE);
+    } else if(fetch_state == VL53L0X_FETCH_FAILED ||
+              VL53L0X_ReadMulti(dev, VL53L0X_REG_RESULT_RANGE_STATUS, data, VL53L0X_RESULT_BLOCK_SIZE) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    ranging_data->deviceStatus = (data[VL53L0X_RESULT_OFFSET_STATUS] & VL53L0X_RESULT_DEVICE_STATUS_MASK) >>
+                                 VL53L0X_RESULT_DEVICE_STATUS_SHIFT;
+    ranging_data->effectiveSpadCount = ((uint16_t)data[VL53L0X_RESULT_OFFSET_EFFECTIVE_SPADS] << 8) |
+                                       data[VL53L0X_RESULT_OFFSET_EFFECTIVE_SPADS + 1];
+    ranging_data->signalRate = ((uint16_t)data[VL53L0X_RESULT_OFFSET_SIGNAL_RATE] << 8) |
+                               data[VL53L0X_RESULT_OFFSET_SIGNAL_RATE + 1];
+    ranging_data->ambientRate = ((uint16_t)data[VL53L0X_RESULT_OFFSET_AMBIENT_RATE] << 8) |
+                                data[VL53L0X_RESULT_OFFSET_AMBIENT_RATE + 1];
+    ranging_data->distance_mm = ((uint16_t)data[VL53L0X_RESULT_OFFSET_RANGE] << 8) |
+                                data[VL53L0X_RESULT_OFFSET_RANGE + 1];
+    ranging_data->sigma = VL53L0X_CalcSigma(dev, ranging_data);
+    
+    ranging_data->rangeStatus = VL53L0X_DecodeRangeStatus(dev, ranging_data);
+    policy = (ranging_data->rangeStatus == VL53L0X_RANGE_VALID) ? VL53L0X_POLICY_ACCEPT_FLAGGED :
+             dev->statusPolicy[ranging_data->rangeStatus];
+    ranging_data->flagged = (ranging_data->rangeStatus != VL53L0X_RANGE_VALID &&
+                             policy == VL53L0X_POLICY_ACCEPT_FLAGGED);
+    dev->statusCount[ranging_data->rangeStatus]++;
+    
+    /* Clear interrupt */
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Repete já em vez de esperar o próximo período; nunca repete uma repetição */
+    if(policy == VL53L0X_POLICY_RETRY && !was_retry && dev->mode != VL53L0X_MODE_CONTINUOUS) {
+        dev->retryPending = true;
+        dev->retryCount++;
+        return VL53L0X_RetryMeasurement(dev);
+    }
+    
+    if(dev->adaptiveEnabled) {
+        return VL53L0X_AdaptBudget(dev, ranging_data);
+    }
+    
+    return VL53L0X_OK;
+}
+
+VL53L0X_Status VL53L0X_SetThresholdWindow(VL53L0X_Dev *dev, VL53L0X_ThresholdMode mode, uint16_t low_mm, uint16_t high_mm)
+{
+    uint8_t gpio_func;
+    uint16_t thresh_low_mm = low_mm;
+    
+    if(low_mm > VL53L0X_THRESHOLD_MAX_MM || high_mm > VL53L0X_THRESHOLD_MAX_MM) {
+        return VL53L0X_ERROR;
+    }
+    if((mode == VL53L0X_THRESHOLD_OUTSIDE || mode == VL53L0X_THRESHOLD_INSIDE) && low_mm >= high_mm) {
+        return VL53L0X_ERROR;
+    }
+    
+    switch(mode) {
+        case VL53L0X_THRESHOLD_OFF:
+            gpio_func = VL53L0X_GPIO_FUNC_NEW_SAMPLE_READY;
+            break;
+        case VL53L0X_THRESHOLD_BELOW:
+            gpio_func = VL53L0X_GPIO_FUNC_THRESHOLD_LOW;
+            break;
+        case VL53L0X_THRESHOLD_ABOVE:
+            gpio_func = VL53L0X_GPIO_FUNC_THRESHOLD_HIGH;
+            break;
+        case VL53L0X_THRESHOLD_OUTSIDE:
+            gpio_func = VL53L0X_GPIO_FUNC_THRESHOLD_OUT;
+            break;
+        case VL53L0X_THRESHOLD_INSIDE:
+            /* Sem modo "dentro" no hardware: o sensor filtra pelo limite superior
+               (ignora alvo ausente/distante) e o inferior é verificado na leitura */
+            gpio_func = VL53L0X_GPIO_FUNC_THRESHOLD_LOW;
+            thresh_low_mm = high_mm;
+            break;
+        default:
+            return VL53L0X_ERROR;
+    }
+    
+    /* Limiares em unidades de 2mm */
+    if(VL53L0X_WriteReg16(dev, VL53L0X_REG_SYSTEM_THRESH_LOW, thresh_low_mm >> 1) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg16(dev, VL53L0X_REG_SYSTEM_THRESH_HIGH, high_mm >> 1) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG_GPIO, gpio_func) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Descarta a amostra pendente, sinalizada ainda com a configuração anterior */
+    dev->dataReady = false;
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    dev->thresholdMode = mode;
+    dev->thresholdLowMm = low_mm;
+    dev->thresholdHighMm = high_mm;
+    
+    return VL53L0X_OK;
+}
+
+VL53L0X_ThresholdMode VL53L0X_GetThresholdMode(VL53L0X_Dev *dev)
+{
+    return dev->thresholdMode;
+}
+
+VL53L0X_Status VL53L0X_TakeThresholdEvent(VL53L0X_Dev *dev, bool *event)
+{
+    uint16_t range_mm;
+    
+    *event = false;
+    if(!dev->dataReady) {
+        return VL53L0X_OK;
+    }
+    dev->dataReady = false;
+    *event = true;
+    
+    /* Modo "dentro": lê só a distância para aplicar o limite inferior */
+    if(dev->thresholdMode == VL53L0X_THRESHOLD_INSIDE) {
+        if(VL53L0X_ReadReg16(dev, VL53L0X_REG_RESULT_RANGE_VAL, &range_mm) != VL53L0X_OK) {
+            *event = false;
+            return VL53L0X_ERROR;
+        }
+        *event = (range_mm >= dev->thresholdLowMm);
+    }
+    
+    /* Rearma GPIO1 para a próxima amostra que satisfizer a condição */
+    return VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01);
+}
+
+VL53L0X_Status VL53L0X_ReadRangingData(VL53L0X_Dev *dev, VL53L0X_RangingData *ranging_data)
+{
+    VL53L0X_MeasState state;
+    
+    /* Com limiar armado GPIO1 pode nunca sinalizar e o laço abaixo não teria
+       prazo: a leitura bloqueante não é permitida nesse modo */
+    if(dev->thresholdMode != VL53L0X_THRESHOLD_OFF) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Em single-shot uma repetição da política já pode estar em andamento */
+    if(!dev->measurementPending) {
+        if(VL53L0X_StartMeasurement(dev) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+    }
+    
+    /* Aguarda a borda de GPIO1 (EXTI) até o prazo configurado */
+    do {
+        state = VL53L0X_PollMeasurement(dev);
+    } while(state == VL53L0X_MEAS_BUSY);
+    
+    if(state != VL53L0X_MEAS_READY) {
+        return VL53L0X_ERROR;
+    }
+    
+    return VL53L0X_FetchMeasurement(dev, ranging_data);
+}
+
+static bool VL53L0X_IsValidReading(const VL53L0X_RangingData *ranging_data)
+{
+    /* Sinal e sigma já entram no status; status não válido só passa marcado */
+    return (ranging_data->rangeStatus == VL53L0X_RANGE_VALID || ranging_data->flagged);
+}
+
+VL53L0X_Status VL53L0X_SetStatusPolicy(VL53L0X_Dev *dev, VL53L0X_RangeStatus status, VL53L0X_StatusPolicy policy)
+{
+    if(status == VL53L0X_RANGE_VALID || status >= VL53L0X_RANGE_STATUS_COUNT || policy > VL53L0X_POLICY_RETRY) {
+        return VL53L0X_ERROR;
+    }
+    
+    dev->statusPolicy[status] = policy;
+    
+    return VL53L0X_OK;
+}
+
+VL53L0X_StatusPolicy VL53L0X_GetStatusPolicy(VL53L0X_Dev *dev, VL53L0X_RangeStatus status)
+{
+    if(status >= VL53L0X_RANGE_STATUS_COUNT) {
+        return VL53L0X_POLICY_DROP;
+    }
+    
+    return (VL53L0X_StatusPolicy)dev->statusPolicy[status];
+}
+
+uint32_t VL53L0X_GetStatusCount(VL53L0X_Dev *dev, VL53L0X_RangeStatus status)
+{
+    if(status >= VL53L0X_RANGE_STATUS_COUNT) {
+        return 0;
+    }
+    
+    return dev->statusCount[status];
+}
+
+void VL53L0X_ResetStatusCounts(VL53L0X_Dev *dev)
+{
+    memset(dev->statusCount, 0, sizeof(dev->statusCount));
+    dev->retryCount = 0;
+}
+
+const char *VL53L0X_GetRangeStatusName(VL53L0X_RangeStatus status)
+{
+    if(status >= VL53L0X_RANGE_STATUS_COUNT) {
+        return "?";
+    }
+    
+    return range_status_names[status];
+}
+
+VL53L0X_Status VL53L0X_SetAdaptiveBudget(VL53L0X_Dev *dev, const VL53L0X_AdaptiveBudget *config)
+{
+    dev->adaptiveSigmaSum = 0;
+    dev->adaptiveSamples = 0;
+    
+    if(config == NULL) {
+        dev->adaptiveEnabled = false;
+        return VL53L0X_OK;
+    }
+    
+    /* Alvo limitado a VL53L0X_SIGMA_MAX: as contas da decisão cabem em 32 bits */
+    if(config->targetSigma == 0 || config->targetSigma > VL53L0X_SIGMA_MAX ||
+       config->minBudgetUs < VL53L0X_MIN_TIMING_BUDGET || config->maxBudgetUs < config->minBudgetUs ||
+       config->maxBudgetUs > VL53L0X_MAX_TIMING_BUDGET ||
+       config->hysteresisPct >= 100 || config->windowSamples == 0) {
+        return VL53L0X_ERROR;
+    }
+    
+    memcpy(&dev->adaptive, config, sizeof(VL53L0X_AdaptiveBudget));
+    dev->adaptiveEnabled = true;
+    
+    return VL53L0X_OK;
+}
+
+const VL53L0X_AdaptiveBudget *VL53L0X_GetAdaptiveBudget(VL53L0X_Dev *dev)
+{
+    return dev->adaptiveEnabled ? &dev->adaptive : NULL;
+}
+
+RangeFilter *VL53L0X_GetFilter(VL53L0X_Dev *dev)
+{
+    return &dev->filter;
+}
+
+bool VL53L0X_FilterMeasurement(VL53L0X_Dev *dev, const VL53L0X_RangingData *ranging_data, uint16_t *distance)
+{
+    /* Amostra inválida não entra na cadeia, mas quebra a sequência do gate */
+    if(!VL53L0X_IsValidReading(ranging_data)) {
+        RangeFilter_Invalidate(&dev->filter);
+        return false;
+    }
+    
+    /* Salto máximo, leituras consecutivas, mediana, Hampel e EMA conforme a cadeia */
+    if(!RangeFilter_Process(&dev->filter, ranging_data->distance_mm, ranging_data->sigma, distance)) {
+        return false;
+    }
+    
+    memcpy(&dev->lastRangingData, ranging_data, sizeof(VL53L0X_RangingData));
+    
+    return true;
+}
+
+VL53L0X_Status VL53L0X_ReadDistance(VL53L0X_Dev *dev, volatile uint16_t *distance)
+{
+    VL53L0X_RangingData ranging_data;
+    uint16_t filtered;
+    
+    /* Lê os dados do sensor */
+    if(VL53L0X_ReadRangingData(dev, &ranging_data) != VL53L0X_OK) {
+        RangeFilter_Invalidate(&dev->filter);
+        return VL53L0X_ERROR;
+    }
+    
+    /* Atualiza a distância apenas quando a cadeia de filtros gera saída */
+    if(VL53L0X_FilterMeasurement(dev, &ranging_data, &filtered)) {
+        *distance = filtered;
+    }
+    
+    return VL53L0X_OK;
+}
+
+/* Private Functions */
+
+static VL53L0X_Status VL53L0X_WriteReg(VL53L0X_Dev *dev, uint8_t reg, uint8_t value)
+{
+    return VL53L0X_WriteMulti(dev, reg, &value, 1);
+}
+
+static VL53L0X_Status VL53L0X_ReadReg(VL53L0X_Dev *dev, uint8_t reg, uint8_t *value)
+{
+    return VL53L0X_ReadMulti(dev, reg, value, 1);
+}
+
+static VL53L0X_Status VL53L0X_ReadMulti(VL53L0X_Dev *dev, uint8_t reg, uint8_t *data, uint8_t count)
+{
+    /* Configuração conhecida: sem tráfego no barramento */
+    if(VL53L0X_ShadowRead(dev, reg, data, count)) {
+        return VL53L0X_OK;
+    }
+    
+    /* Índice e leitura na mesma transação, com repeated start */
+    if(I2CBus_Read(dev->hi2c, dev->address, reg, data, count) != HAL_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    VL53L0X_ShadowFill(dev, reg, data, count);
+    
+    return VL53L0X_OK;
+}
+
+static VL53L0X_Status VL53L0X_WriteMulti(VL53L0X_Dev *dev, uint8_t reg, const uint8_t *data, uint8_t count)
+{
+    uint8_t first = 0;
+    uint8_t last = count;
+    
+    /* Bytes das pontas que o sensor já tem não são reenviados */
+    while(first < last && VL53L0X_ShadowMatches(dev, reg + first, data[first])) {
+        first++;
+    }
+    while(last > first && VL53L0X_ShadowMatches(dev, reg + last - 1, data[last - 1])) {
+        last--;
+    }
+    if(first == last) {
+        return VL53L0X_OK;
+    }
+    
+    /* Rajadas vão por DMA (i2c_bus); o índice é enviado antes dos dados */
+    if(I2CBus_Write(dev->hi2c, dev->address, reg + first, &data[first], last - first) != HAL_OK) {
+        VL53L0X_ShadowWrite(dev, reg, data, count, false);
+        return VL53L0X_ERROR;
+    }
+    
+    VL53L0X_ShadowWrite(dev, reg, data, count, true);
+    
+    return VL53L0X_OK;
+}
 
-VL53L0X_Status VL53L0X_Init(I2C_HandleTypeDef *hi2c)
+static VL53L0X_Status VL53L0X_WriteReg16(VL53L0X_Dev *dev, uint8_t reg, uint16_t value)
 {
-    uint8_t temp;
+    uint8_t data[2];
+    data[0] = (uint8_t)(value >> 8);
+    data[1] = (uint8_t)value;
     
-    /* Wait for boot */
-    HAL_Delay(100);
+    return VL53L0X_WriteMulti(dev, reg, data, 2);
+}
+
+static VL53L0X_Status VL53L0X_ReadReg16(VL53L0X_Dev *dev, uint8_t reg, uint16_t *value)
+{
+    uint8_t data[2];
     
-    /* Check sensor ID */
-    if(VL53L0X_ReadReg(hi2c, 0xC0, &temp) != VL53L0X_OK) {
+    if(VL53L0X_ReadMulti(dev, reg, data, 2) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
-    /* Initialize sensor with default settings */
-    if(VL53L0X_WriteReg(hi2c, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, 0xFF) != VL53L0X_OK) {
+    *value = ((uint16_t)data[0] << 8) | data[1];
+    
+    return VL53L0X_OK;
+}
+
+static VL53L0X_Status VL53L0X_WriteReg32(VL53L0X_Dev *dev, uint8_t reg, uint32_t value)
+{
+    uint8_t data[4];
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)value;
+    
+    return VL53L0X_WriteMulti(dev, reg, data, 4);
+}
+
+/* Executa uma tabela de registradores. A ordem da tabela é mantida; o
+   ganho vem de manter registradores vizinhos adjacentes e crescentes */
+static VL53L0X_Status VL53L0X_WriteSequence(VL53L0X_Dev *dev, const VL53L0X_RegValue *seq, uint16_t count)
+{
+    uint8_t burst[VL53L0X_SEQUENCE_MAX_BURST];
+    uint16_t i = 0;
+    uint8_t len;
+    
+    while(i < count) {
+        /* Seleção de página: sempre isolada, omitida pela cópia se a página não muda */
+        if(seq[i].reg == VL53L0X_REG_PAGE_SELECT) {
+            if(VL53L0X_WriteReg(dev, VL53L0X_REG_PAGE_SELECT, seq[i].value) != VL53L0X_OK) {
+                return VL53L0X_ERROR;
+            }
+            i++;
+            continue;
+        }
+    
+        /* Endereços consecutivos na tabela viram uma escrita com auto-incremento */
+        len = 0;
+        do {
+            burst[len] = seq[i + len].value;
+            len++;
+        } while(i + len < count && len < VL53L0X_SEQUENCE_MAX_BURST &&
+                seq[i + len].reg == seq[i].reg + len && seq[i + len].reg != VL53L0X_REG_PAGE_SELECT);
+    
+        if(VL53L0X_WriteMulti(dev, seq[i].reg, burst, len) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        i += len;
+    }
+    
+    return VL53L0X_OK;
+}
+
+/* Conclusão da leitura assíncrona do bloco de resultado (contexto de interrupção) */
+static void VL53L0X_FetchComplete(void *context, HAL_StatusTypeDef status)
+{
+    VL53L0X_Dev *dev = (VL53L0X_Dev *)context;
+    
+    dev->fetchState = (status == HAL_OK) ? VL53L0X_FETCH_DONE : VL53L0X_FETCH_FAILED;
+}
+
+/* Esquece todos os valores conhecidos e o estado de página/acesso */
+static void VL53L0X_ShadowReset(VL53L0X_Dev *dev)
+{
+    memset(dev->shadowValid, 0, sizeof(dev->shadowValid));
+    dev->page = VL53L0X_PAGE_UNKNOWN;
+    dev->privateAccess = VL53L0X_PRIVATE_ACCESS_UNKNOWN;
+}
+
+/* Posição do registrador na cópia, ou -1 se não é mantido */
+static int16_t VL53L0X_ShadowSlot(uint8_t reg)
+{
+    int16_t slot = 0;
+    
+    for(uint8_t i = 0; i < sizeof(shadow_ranges) / sizeof(shadow_ranges[0]); i++) {
+        if(reg < shadow_ranges[i].first) {
+            break;
+        }
+        if(reg < shadow_ranges[i].first + shadow_ranges[i].count) {
+            return slot + (reg - shadow_ranges[i].first);
+        }
+        slot += shadow_ranges[i].count;
+    }
+    
+    return -1;
+}
+
+/* A cópia só vale no mapa normal: página 0 e acessos privados fechados */
+static bool VL53L0X_ShadowActive(VL53L0X_Dev *dev)
+{
+    return (dev->page == 0 && dev->privateAccess == 0);
+}
+
+/* true se o sensor já tem esse valor: a escrita pode ser omitida */
+static bool VL53L0X_ShadowMatches(VL53L0X_Dev *dev, uint8_t reg, uint8_t value)
+{
+    int16_t slot;
+    
+    if(reg == VL53L0X_REG_PAGE_SELECT) {
+        return (dev->page == value);
+    }
+    if(!VL53L0X_ShadowActive(dev)) {
+        return false;
+    }
+    
+    slot = VL53L0X_ShadowSlot(reg);
+    
+    return (slot >= 0 && (dev->shadowValid[slot / 8] & (1 << (slot % 8))) && dev->shadow[slot] == value);
+}
+
+/* Write-through: atualiza a cópia após uma escrita. Se a escrita falhou,
+   o valor no sensor é incerto e o registrador deixa de ser conhecido */
+static void VL53L0X_ShadowWrite(VL53L0X_Dev *dev, uint8_t reg, const uint8_t *data, uint8_t count, bool written)
+{
+    for(uint8_t i = 0; i < count; i++) {
+        uint8_t r = reg + i;
+        int16_t slot;
+    
+        /* Página e acessos privados mudam o mapa de registradores */
+        if(r == VL53L0X_REG_PAGE_SELECT) {
+            dev->page = written ? data[i] : VL53L0X_PAGE_UNKNOWN;
+            continue;
+        }
+        if(r == VL53L0X_REG_PRIVATE_ACCESS && dev->page != 1) {
+            if(!written || data[i] != 0 || dev->page != 0) {
+                dev->privateAccess |= VL53L0X_PRIVATE_ACCESS_80;
+            } else {
+                dev->privateAccess &= ~VL53L0X_PRIVATE_ACCESS_80;
+            }
+            continue;
+        }
+        if(r == 0x00 && dev->page != 0) {
+            if(!written || data[i] == 0 || dev->page != 1) {
+                dev->privateAccess |= VL53L0X_PRIVATE_ACCESS_PAGE1;
+            } else {
+                dev->privateAccess &= ~VL53L0X_PRIVATE_ACCESS_PAGE1;
+            }
+            continue;
+        }
+    
+        /* Outra página conhecida: não toca os registradores da página 0 */
+        if(dev->page != 0 && dev->page != VL53L0X_PAGE_UNKNOWN) {
+            continue;
+        }
+    
+        slot = VL53L0X_ShadowSlot(r);
+        if(slot < 0) {
+            continue;
+        }
+        if(written && VL53L0X_ShadowActive(dev)) {
+            dev->shadow[slot] = data[i];
+            dev->shadowValid[slot / 8] |= (1 << (slot % 8));
+        } else {
+            dev->shadowValid[slot / 8] &= ~(1 << (slot % 8));
+        }
+    }
+}
+
+/* Leitura servida pela cópia se todos os bytes são conhecidos */
+static bool VL53L0X_ShadowRead(VL53L0X_Dev *dev, uint8_t reg, uint8_t *data, uint8_t count)
+{
+    if(!VL53L0X_ShadowActive(dev)) {
+        return false;
+    }
+    
+    for(uint8_t i = 0; i < count; i++) {
+        int16_t slot = VL53L0X_ShadowSlot(reg + i);
+    
+        if(slot < 0 || !(dev->shadowValid[slot / 8] & (1 << (slot % 8)))) {
+            return false;
+        }
+        data[i] = dev->shadow[slot];
+    }
+    
+    return true;
+}
+
+/* Guarda o que foi lido do sensor: a próxima leitura ou RMW não usa o barramento */
+static void VL53L0X_ShadowFill(VL53L0X_Dev *dev, uint8_t reg, const uint8_t *data, uint8_t count)
+{
+    if(!VL53L0X_ShadowActive(dev)) {
+        return;
+    }
+    
+    for(uint8_t i = 0; i < count; i++) {
+        int16_t slot = VL53L0X_ShadowSlot(reg + i);
+    
+        if(slot >= 0) {
+            dev->shadow[slot] = data[i];
+            dev->shadowValid[slot / 8] |= (1 << (slot % 8));
+        }
+    }
+}
+
+static VL53L0X_Status VL53L0X_WaitBoot(VL53L0X_Dev *dev)
+{
+    uint8_t model_id;
+    uint32_t start_tick = HAL_GetTick();
+    
+    /* O sensor não responde (NACK) até concluir o boot */
+    while(VL53L0X_ReadReg(dev, VL53L0X_REG_IDENTIFICATION_MODEL_ID, &model_id) != VL53L0X_OK ||
+          model_id != VL53L0X_MODEL_ID) {
+        if(HAL_GetTick() - start_tick >= VL53L0X_BOOT_TIMEOUT) {
+            return VL53L0X_ERROR;
+        }
+        HAL_Delay(1);
+    }
+    
+    return VL53L0X_OK;
+}
+
+static VL53L0X_Status VL53L0X_ReadRefCalibration(VL53L0X_Dev *dev, uint8_t *vhv_settings, uint8_t *phase_cal)
+{
+    if(VL53L0X_WriteSequence(dev, ref_calibration_open, sizeof(ref_calibration_open) / sizeof(ref_calibration_open[0])) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_VHV_SETTINGS, vhv_settings) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_PHASE_CAL, phase_cal) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
+    *phase_cal &= 0xEF;
     
-    /* Set GPIO config to interrupt on new sample ready */
-    if(VL53L0X_WriteReg(hi2c, VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG_GPIO, 0x04) != VL53L0X_OK) {
+    return VL53L0X_WriteSequence(dev, ref_calibration_close, sizeof(ref_calibration_close) / sizeof(ref_calibration_close[0]));
+}
+
+static VL53L0X_Status VL53L0X_WriteRefCalibration(VL53L0X_Dev *dev, uint8_t vhv_settings, uint8_t phase_cal)
+{
+    uint8_t temp;
+    
+    if(VL53L0X_WriteSequence(dev, ref_calibration_open, sizeof(ref_calibration_open) / sizeof(ref_calibration_open[0])) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_VHV_SETTINGS, vhv_settings) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
-    /* Set interrupt polarity to active high */
-    if(VL53L0X_WriteReg(hi2c, VL53L0X_REG_GPIO_HV_MUX_ACTIVE_HIGH, 0x21) != VL53L0X_OK) {
+    /* Preserva o bit 7 do registrador de fase */
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_PHASE_CAL, &temp) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_PHASE_CAL, (temp & 0x80) | phase_cal) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
-    return VL53L0X_OK;
+    return VL53L0X_WriteSequence(dev, ref_calibration_close, sizeof(ref_calibration_close) / sizeof(ref_calibration_close[0]));
 }
 
-VL53L0X_Status VL53L0X_SetHighAccuracy(I2C_HandleTypeDef *hi2c)
+static VL53L0X_Status VL53L0X_GetSpadInfo(VL53L0X_Dev *dev, uint8_t *count, bool *type_is_aperture)
 {
-    /* Configure timing budget for high accuracy */
-    if(VL53L0X_WriteReg(hi2c, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, 0xFF) != VL53L0X_OK) {
+    uint8_t temp;
+    uint32_t start_tick;
+    
+    if(VL53L0X_WriteSequence(dev, spad_info_open, sizeof(spad_info_open) / sizeof(spad_info_open[0])) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
-    /* Set timing budget (~200ms) */
-    uint16_t budget = VL53L0X_HIGH_ACCURACY_TIMING_BUDGET / 1000;
-    if(VL53L0X_WriteReg(hi2c, VL53L0X_REG_SYSTEM_INTERMEASUREMENT_PERIOD, budget) != VL53L0X_OK) {
+    if(VL53L0X_ReadReg(dev, 0x83, &temp) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, 0x83, temp | 0x04) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
-    return VL53L0X_OK;
+    if(VL53L0X_WriteSequence(dev, spad_info_request, sizeof(spad_info_request) / sizeof(spad_info_request[0])) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    /* Aguarda o NVM disponibilizar as informações de SPAD */
+    start_tick = HAL_GetTick();
+    do {
+        if(VL53L0X_ReadReg(dev, 0x83, &temp) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        if(HAL_GetTick() - start_tick >= VL53L0X_MEASUREMENT_TIMEOUT) {
+            return VL53L0X_ERROR;
+        }
+    } while(temp == 0x00);
+    
+    if(VL53L0X_WriteReg(dev, 0x83, 0x01) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_ReadReg(dev, 0x92, &temp) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    *count = temp & 0x7F;
+    *type_is_aperture = (temp >> 7) & 0x01;
+    
+    if(VL53L0X_WriteReg(dev, 0x81, 0x00) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, 0xFF, 0x06) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_ReadReg(dev, 0x83, &temp) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, 0x83, temp & ~0x04) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    return VL53L0X_WriteSequence(dev, spad_info_close, sizeof(spad_info_close) / sizeof(spad_info_close[0]));
 }
 
-VL53L0X_Status VL53L0X_ReadRangingData(I2C_HandleTypeDef *hi2c, VL53L0X_RangingData *ranging_data)
+static VL53L0X_Status VL53L0X_PerformSingleRefCalibration(VL53L0X_Dev *dev, uint8_t vhv_init_byte)
 {
     uint8_t temp;
-    uint8_t data[2];
+    uint32_t start_tick;
     
-    /* Start single range measurement */
-    if(VL53L0X_WriteReg(hi2c, VL53L0X_REG_SYSRANGE_START, 0x01) != VL53L0X_OK) {
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSRANGE_START, VL53L0X_SYSRANGE_MODE_SINGLESHOT | vhv_init_byte) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
-    /* Wait for range measurement completion */
+    /* Calibração só roda na inicialização: polling com prazo é suficiente */
+    start_tick = HAL_GetTick();
     do {
-        if(VL53L0X_ReadReg(hi2c, VL53L0X_REG_RESULT_RANGE_STATUS, &temp) != VL53L0X_OK) {
+        if(VL53L0X_ReadReg(dev, VL53L0X_REG_RESULT_INTERRUPT_STATUS, &temp) != VL53L0X_OK) {
             return VL53L0X_ERROR;
         }
-    } while((temp & 0x01) == 0);
+        if(HAL_GetTick() - start_tick >= VL53L0X_MEASUREMENT_TIMEOUT) {
+            return VL53L0X_ERROR;
+        }
+    } while((temp & 0x07) == 0);
+    
+    if(VL53L0X_WriteReg(dev, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
     
-    /* Read range status and value */
-    ranging_data->rangeStatus = temp >> 4;
+    return VL53L0X_WriteReg(dev, VL53L0X_REG_SYSRANGE_START, 0x00);
+}
+
+static VL53L0X_Status VL53L0X_GetSequenceStepEnables(VL53L0X_Dev *dev, VL53L0X_SequenceStepEnables *enables)
+{
+    uint8_t sequence_config;
     
-    /* Read range value */
-    if(VL53L0X_ReadMulti(hi2c, VL53L0X_REG_RESULT_RANGE_VAL, data, 2) != VL53L0X_OK) {
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_SYSTEM_SEQUENCE_CONFIG, &sequence_config) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
-    /* Convert to mm */
-    ranging_data->distance_mm = ((uint16_t)data[0] << 8) | data[1];
+    enables->tcc         = (sequence_config & VL53L0X_SEQUENCE_ENABLE_TCC) != 0;
+    enables->dss         = (sequence_config & VL53L0X_SEQUENCE_ENABLE_DSS) != 0;
+    enables->msrc        = (sequence_config & VL53L0X_SEQUENCE_ENABLE_MSRC) != 0;
+    enables->pre_range   = (sequence_config & VL53L0X_SEQUENCE_ENABLE_PRE_RANGE) != 0;
+    enables->final_range = (sequence_config & VL53L0X_SEQUENCE_ENABLE_FINAL_RANGE) != 0;
     
-    /* Read signal and ambient rate (opcional, mas útil para filtragem) */
-    if(VL53L0X_ReadMulti(hi2c, VL53L0X_REG_RESULT_RANGE_STATUS + 6, data, 2) != VL53L0X_OK) {
+    return VL53L0X_OK;
+}
+
+static VL53L0X_Status VL53L0X_GetSequenceStepTimeouts(VL53L0X_Dev *dev, const VL53L0X_SequenceStepEnables *enables,
+                                                      VL53L0X_SequenceStepTimeouts *timeouts)
+{
+    uint8_t temp;
+    uint16_t temp16;
+    
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_PRE_RANGE_CONFIG_VCSEL_PERIOD, &temp) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
-    ranging_data->signalRate = ((uint16_t)data[0] << 8) | data[1];
+    timeouts->pre_range_vcsel_period_pclks = VL53L0X_DecodeVcselPeriod(temp);
     
-    /* Clear interrupt */
-    if(VL53L0X_WriteReg(hi2c, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01) != VL53L0X_OK) {
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_MSRC_CONFIG_TIMEOUT_MACROP, &temp) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    timeouts->msrc_dss_tcc_mclks = temp + 1;
+    timeouts->msrc_dss_tcc_us = VL53L0X_TimeoutMclksToMicroseconds(timeouts->msrc_dss_tcc_mclks,
+                                                                   timeouts->pre_range_vcsel_period_pclks);
+    
+    if(VL53L0X_ReadReg16(dev, VL53L0X_REG_PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI, &temp16) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    timeouts->pre_range_mclks = VL53L0X_DecodeTimeout(temp16);
+    timeouts->pre_range_us = VL53L0X_TimeoutMclksToMicroseconds(timeouts->pre_range_mclks,
+                                                                timeouts->pre_range_vcsel_period_pclks);
+    
+    if(VL53L0X_ReadReg(dev, VL53L0X_REG_FINAL_RANGE_CONFIG_VCSEL_PERIOD, &temp) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    timeouts->final_range_vcsel_period_pclks = VL53L0X_DecodeVcselPeriod(temp);
+    
+    if(VL53L0X_ReadReg16(dev, VL53L0X_REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI, &temp16) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
+    timeouts->final_range_mclks = VL53L0X_DecodeTimeout(temp16);
+    
+    /* O registrador do final range inclui o timeout do pre-range */
+    if(enables->pre_range) {
+        timeouts->final_range_mclks -= timeouts->pre_range_mclks;
+    }
+    timeouts->final_range_us = VL53L0X_TimeoutMclksToMicroseconds(timeouts->final_range_mclks,
+                                                                  timeouts->final_range_vcsel_period_pclks);
     
     return VL53L0X_OK;
 }
 
-static bool VL53L0X_IsValidReading(VL53L0X_RangingData *ranging_data)
+/* Status da amostra: código do dispositivo, depois os limites do perfil
+   (sigma antes de sinal, como na API da ST) */
+static uint8_t VL53L0X_DecodeRangeStatus(VL53L0X_Dev *dev, const VL53L0X_RangingData *ranging_data)
 {
-    /* Verifica status da medição */
-    if(ranging_data->rangeStatus != 0) {
-        return false;
+    uint8_t status = device_status_map[ranging_data->deviceStatus & 0x0F];
+    
+    if(status == VL53L0X_RANGE_VALID) {
+        if(ranging_data->sigma > dev->profile->sigmaLimit) {
+            status = VL53L0X_RANGE_SIGMA_FAIL;
+        } else if(ranging_data->signalRate < dev->profile->signalRateLimit) {
+            status = VL53L0X_RANGE_SIGNAL_FAIL;
+        }
     }
     
-    /* Verifica se a taxa de sinal está acima do limite mínimo */
-    if(ranging_data->signalRate < (VL53L0X_SIGNAL_RATE_LIMIT * 65536.0f)) {
-        return false;
+    return status;
+}
+
+/* Nova medição logo após uma amostra descartada pela política */
+static VL53L0X_Status VL53L0X_RetryMeasurement(VL53L0X_Dev *dev)
+{
+    uint32_t period_ms = dev->measurementPeriodMs;
+    
+    if(dev->mode == VL53L0X_MODE_TIMED) {
+        /* Reinicia o modo temporizado: a medição começa agora, não no fim do período */
+        if(VL53L0X_StopContinuous(dev) != VL53L0X_OK) {
+            return VL53L0X_ERROR;
+        }
+        return VL53L0X_StartContinuous(dev, period_ms);
     }
     
-    /* Verifica se a variação da medida não é muito brusca */
-    if(last_valid_distance > 0) {
-        int16_t diff = abs((int16_t)ranging_data->distance_mm - (int16_t)last_valid_distance);
-        if(diff > VL53L0X_MAX_MEASUREMENT_JUMP) {
-            return false;
+    return VL53L0X_StartMeasurement(dev);
+}
+
+/* Acumula a sigma da janela e, ao fim dela, reescala o budget se a média
+   saiu da banda [alvo * (100 - h) / 100, alvo] */
+static VL53L0X_Status VL53L0X_AdaptBudget(VL53L0X_Dev *dev, const VL53L0X_RangingData *ranging_data)
+{
+    const VL53L0X_AdaptiveBudget *config = &dev->adaptive;
+    uint32_t weak_sigma = (uint32_t)config->targetSigma * VL53L0X_ADAPTIVE_WEAK_SIGMA_FACTOR;
+    uint32_t budget_us = dev->timingBudgetUs;
+    uint32_t mean;
+    uint32_t center;
+    uint32_t ratio;
+    
+    /* Só status que dependem da quantidade de sinal entram na média */
+    switch(ranging_data->rangeStatus) {
+        case VL53L0X_RANGE_VALID:
+        case VL53L0X_RANGE_SIGMA_FAIL:
+            dev->adaptiveSigmaSum += (ranging_data->sigma < weak_sigma) ? ranging_data->sigma : weak_sigma;
+            break;
+        case VL53L0X_RANGE_SIGNAL_FAIL:
+            dev->adaptiveSigmaSum += weak_sigma;
+            break;
+        default:
+            return VL53L0X_OK;
+    }
+    if(++dev->adaptiveSamples < config->windowSamples) {
+        return VL53L0X_OK;
+    }
+    
+    mean = dev->adaptiveSigmaSum / dev->adaptiveSamples;
+    dev->adaptiveSigmaSum = 0;
+    dev->adaptiveSamples = 0;
+    
+    if(mean > config->targetSigma || mean * 100 < (uint32_t)config->targetSigma * (100 - config->hysteresisPct)) {
+        /* sigma² ~ 1 / budget: budget * (média / centro da banda)², em Q8 */
+        center = ((uint32_t)config->targetSigma * (200 - config->hysteresisPct) + 100) / 200;
+        if(center == 0) {
+            center = 1;
+        }
+        ratio = ((mean * mean) << 8) / (center * center);
+        if(ratio < 256 / VL53L0X_ADAPTIVE_MAX_STEP) {
+            ratio = 256 / VL53L0X_ADAPTIVE_MAX_STEP;
+        } else if(ratio > 256 * VL53L0X_ADAPTIVE_MAX_STEP) {
+            ratio = 256 * VL53L0X_ADAPTIVE_MAX_STEP;
         }
+        budget_us = (uint32_t)(((uint64_t)budget_us * ratio) >> 8);
+        budget_us = ((budget_us + 999) / 1000) * 1000;
     }
     
-    return true;
+    /* Limites do usuário valem mesmo dentro da banda */
+    if(budget_us < config->minBudgetUs) {
+        budget_us = config->minBudgetUs;
+    } else if(budget_us > config->maxBudgetUs) {
+        budget_us = config->maxBudgetUs;
+    }
+    
+    if(budget_us == dev->timingBudgetUs) {
+        return VL53L0X_OK;
+    }
+    
+    return VL53L0X_ApplyBudget(dev, budget_us);
 }
 
-VL53L0X_Status VL53L0X_ReadDistance(I2C_HandleTypeDef *hi2c, volatile uint16_t *distance)
+/* Reprograma o budget mantendo o modo de medição; no modo temporizado o
+   período acompanha o budget com a mesma folga */
+static VL53L0X_Status VL53L0X_ApplyBudget(VL53L0X_Dev *dev, uint32_t budget_us)
 {
-    VL53L0X_RangingData ranging_data;
+    VL53L0X_RangingMode mode = dev->mode;
+    uint32_t period_ms = dev->measurementPeriodMs;
+    uint32_t budget_ms = (dev->timingBudgetUs + 999) / 1000;
+    uint32_t margin_ms = (period_ms > budget_ms) ? (period_ms - budget_ms) : 0;
+    VL53L0X_Status status;
     
-    /* Lê os dados do sensor */
-    if(VL53L0X_ReadRangingData(hi2c, &ranging_data) != VL53L0X_OK) {
-        valid_reading_count = 0;
+    if(mode != VL53L0X_MODE_SINGLE && VL53L0X_StopContinuous(dev) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
-    /* Verifica se a leitura é válida */
-    if(VL53L0X_IsValidReading(&ranging_data)) {
-        valid_reading_count++;
-        
-        /* Atualiza a distância apenas após várias leituras válidas consecutivas */
-        if(valid_reading_count >= VL53L0X_VALID_READS_BEFORE_UPDATE) {
-            *distance = ranging_data.distance_mm;
-            last_valid_distance = ranging_data.distance_mm;
-            memcpy(&last_ranging_data, &ranging_data, sizeof(VL53L0X_RangingData));
+    status = VL53L0X_SetMeasurementTimingBudget(dev, budget_us);
+    if(status == VL53L0X_OK) {
+        dev->adaptiveChanges++;
+        if(mode == VL53L0X_MODE_TIMED) {
+            period_ms = (budget_us + 999) / 1000 + margin_ms;
         }
-    } else {
-        valid_reading_count = 0;
     }
     
-    return VL53L0X_OK;
+    /* Retoma a medição mesmo se o budget não mudou */
+    if(mode != VL53L0X_MODE_SINGLE && VL53L0X_StartContinuous(dev, period_ms) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    return status;
 }
 
-/* Private Functions */
+/* Termos da sigma que dependem só da temporização programada (VL53L0X_calc_sigma_estimate) */
+static void VL53L0X_UpdateSigmaTiming(VL53L0X_Dev *dev, const VL53L0X_SequenceStepTimeouts *timeouts,
+                                      uint32_t final_range_mclks)
+{
+    uint32_t vcsel_width = (timeouts->final_range_vcsel_period_pclks == 8) ? 2 : 3;
+    uint32_t duration;
+    uint32_t integration_ms;
+    
+    /* Tempo total de VCSEL ligado (pre-range + final range) em µs */
+    duration = vcsel_width * 2048 * (timeouts->pre_range_mclks + final_range_mclks);
+    duration = (duration + 500) / 1000;
+    duration *= VL53L0X_PLL_PERIOD_PS;
+    dev->sigmaVcselDuration_us = (duration + 500) / 1000;
+    
+    /* Referência: 1mm * sqrt(25ms / integração), em 16.16 (m) */
+    integration_ms = (VL53L0X_TimeoutMclksToMicroseconds(final_range_mclks, timeouts->final_range_vcsel_period_pclks) +
+                      timeouts->pre_range_us + 500) / 1000;
+    if(integration_ms == 0) {
+        integration_ms = 1;
+    }
+    dev->sigmaRef = VL53L0X_ISqrt((VL53L0X_FP1616(VL53L0X_SIGMA_REF_INTEGRATION_MS) + integration_ms / 2) /
+                                  integration_ms) << 8;
+    dev->sigmaRef = (dev->sigmaRef + 500) / 1000;
+}
 
-static VL53L0X_Status VL53L0X_WriteReg(I2C_HandleTypeDef *hi2c, uint8_t reg, uint8_t value)
+/* Estimativa de sigma da API da ST em ponto fixo, sem compensação de crosstalk
+   (fator de largura de pulso = 1). Só divisões de 32 bits (UDIV do Cortex-M3) */
+static uint16_t VL53L0X_CalcSigma(VL53L0X_Dev *dev, const VL53L0X_RangingData *ranging_data)
 {
-    uint8_t data[2];
-    data[0] = reg;
-    data[1] = value;
+    uint32_t signal_rate = ranging_data->signalRate;     // 9.7
+    uint32_t ambient_x1000 = (uint32_t)ranging_data->ambientRate * 1000;
+    uint32_t total_events;
+    uint32_t amb_to_signal;
+    uint32_t sigma_p2;
+    uint32_t sigma_p3;
+    uint32_t sqr1;
+    uint32_t sqr2;
+    uint32_t sigma_rtn;
+    uint32_t sigma;
     
-    if(HAL_I2C_Master_Transmit(hi2c, VL53L0X_DEFAULT_ADDRESS << 1, data, 2, 100) != HAL_OK) {
-        return VL53L0X_ERROR;
+    /* Sem retorno: nenhum SPAD efetivo ou taxa de sinal nula */
+    if(signal_rate == 0 || ranging_data->effectiveSpadCount == 0) {
+        return VL53L0X_SIGMA_MAX;
     }
     
-    return VL53L0X_OK;
+    /* Eventos de sinal no tempo de VCSEL ligado (9.7 -> 24.8, produto em 64 bits) */
+    total_events = (uint32_t)((((VL53L0X_FP97To1616(signal_rate) + 0x80) >> 8) *
+                               (uint64_t)dev->sigmaVcselDuration_us + 0x80) >> 8);
+    if(total_events < 1) {
+        return VL53L0X_SIGMA_MAX;
+    }
+    if(total_events > 0xFFFFFFFFUL / 12) {
+        total_events = 0xFFFFFFFFUL / 12;
+    }
+    
+    /* Razão ambiente (kcps) / sinal (mcps) em 16.16: parte inteira e fração
+       separadas para não estourar 32 bits */
+    amb_to_signal = ambient_x1000 / signal_rate;
+    if(amb_to_signal >= (VL53L0X_SIGMA_AMB_TO_SIGNAL_MAX >> 16)) {
+        amb_to_signal = VL53L0X_SIGMA_AMB_TO_SIGNAL_MAX;
+    } else {
+        amb_to_signal = (amb_to_signal << 16) + (((ambient_x1000 % signal_rate) << 16) / signal_rate);
+        if(amb_to_signal > VL53L0X_SIGMA_AMB_TO_SIGNAL_MAX) {
+            amb_to_signal = VL53L0X_SIGMA_AMB_TO_SIGNAL_MAX;
+        }
+    }
+    sigma_p2 = amb_to_signal * VL53L0X_SIGMA_AMBIENT_WIDTH_CENTI_NS;
+    
+    /* Ruído de um pulso quadrado: largura / sqrt(12 * eventos) */
+    sigma_p3 = 2 * VL53L0X_ISqrt(total_events * 12);
+    
+    /* sqrt(pulso² + ambiente²) em centi-ns */
+    sqr1 = (uint32_t)VL53L0X_SIGMA_PULSE_WIDTH_CENTI_NS * VL53L0X_SIGMA_PULSE_WIDTH_CENTI_NS;
+    sqr2 = (sigma_p2 + 0x8000) >> 16;
+    sqr2 *= sqr2;
+    
+    /* Tempo -> distância: velocidade da luz em µm/0.1ns, resultado em 16.16 (m) */
+    sigma_rtn = (((VL53L0X_ISqrt(sqr1 + sqr2) << 16) + 50) / 100) / sigma_p3;
+    if(sigma_rtn > ((uint32_t)VL53L0X_SIGMA_RTN_MAX * 10000) / VL53L0X_SPEED_OF_LIGHT_IN_AIR) {
+        sigma_rtn = VL53L0X_SIGMA_RTN_MAX;
+    } else {
+        sigma_rtn = (sigma_rtn * VL53L0X_SPEED_OF_LIGHT_IN_AIR + 5000) / 10000;
+        if(sigma_rtn > VL53L0X_SIGMA_RTN_MAX) {
+            sigma_rtn = VL53L0X_SIGMA_RTN_MAX;
+        }
+    }
+    
+    /* Combina com a referência do budget: sqrt(rtn² + ref²), m -> mm */
+    sigma = 1000 * VL53L0X_ISqrt(sigma_rtn * sigma_rtn + dev->sigmaRef * dev->sigmaRef);
+    if(sigma > VL53L0X_FP1616(VL53L0X_SIGMA_MAX)) {
+        return VL53L0X_SIGMA_MAX;
+    }
+    
+    return VL53L0X_FP1616ToInt(sigma);
 }
 
-static VL53L0X_Status VL53L0X_ReadReg(I2C_HandleTypeDef *hi2c, uint8_t reg, uint8_t *value)
+static VL53L0X_Status VL53L0X_ReadTimingBudget(VL53L0X_Dev *dev, uint32_t *budget_us)
 {
-    if(HAL_I2C_Master_Transmit(hi2c, VL53L0X_DEFAULT_ADDRESS << 1, &reg, 1, 100) != HAL_OK) {
+    VL53L0X_SequenceStepEnables enables;
+    VL53L0X_SequenceStepTimeouts timeouts;
+    uint32_t budget = VL53L0X_BUDGET_START_OVERHEAD + VL53L0X_BUDGET_END_OVERHEAD;
+    
+    if(VL53L0X_GetSequenceStepEnables(dev, &enables) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
-    
-    if(HAL_I2C_Master_Receive(hi2c, VL53L0X_DEFAULT_ADDRESS << 1, value, 1, 100) != HAL_OK) {
+    if(VL53L0X_GetSequenceStepTimeouts(dev, &enables, &timeouts) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
+    if(enables.tcc) {
+        budget += timeouts.msrc_dss_tcc_us + VL53L0X_BUDGET_TCC_OVERHEAD;
+    }
+    
+    if(enables.dss) {
+        budget += 2 * (timeouts.msrc_dss_tcc_us + VL53L0X_BUDGET_DSS_OVERHEAD);
+    } else if(enables.msrc) {
+        budget += timeouts.msrc_dss_tcc_us + VL53L0X_BUDGET_MSRC_OVERHEAD;
+    }
+    
+    if(enables.pre_range) {
+        budget += timeouts.pre_range_us + VL53L0X_BUDGET_PRE_RANGE_OVERHEAD;
+    }
+    
+    if(enables.final_range) {
+        budget += timeouts.final_range_us + VL53L0X_BUDGET_FINAL_RANGE_OVERHEAD;
+    }
+    
+    *budget_us = budget;
+    
     return VL53L0X_OK;
 }
 
-static VL53L0X_Status VL53L0X_ReadMulti(I2C_HandleTypeDef *hi2c, uint8_t reg, uint8_t *data, uint8_t count)
+/* Timeouts são gravados como LSB * 2^MSB + 1 */
+static uint16_t VL53L0X_DecodeTimeout(uint16_t reg_val)
 {
-    if(HAL_I2C_Master_Transmit(hi2c, VL53L0X_DEFAULT_ADDRESS << 1, &reg, 1, 100) != HAL_OK) {
-        return VL53L0X_ERROR;
+    return (uint16_t)((reg_val & 0x00FF) << ((reg_val & 0xFF00) >> 8)) + 1;
+}
+
+static uint16_t VL53L0X_EncodeTimeout(uint32_t timeout_mclks)
+{
+    uint32_t ls_byte;
+    uint16_t ms_byte = 0;
+    
+    if(timeout_mclks == 0) {
+        return 0;
+    }
+    
+    ls_byte = timeout_mclks - 1;
+    while((ls_byte & 0xFFFFFF00) > 0) {
+        ls_byte >>= 1;
+        ms_byte++;
     }
     
-    if(HAL_I2C_Master_Receive(hi2c, VL53L0X_DEFAULT_ADDRESS << 1, data, count, 100) != HAL_OK) {
+    return (ms_byte << 8) | (ls_byte & 0xFF);
+}
+
+static uint8_t VL53L0X_DecodeVcselPeriod(uint8_t reg_val)
+{
+    return (reg_val + 1) << 1;
+}
+
+static uint8_t VL53L0X_EncodeVcselPeriod(uint8_t period_pclks)
+{
+    return (period_pclks >> 1) - 1;
+}
+
+static VL53L0X_Status VL53L0X_WriteStopVariable(VL53L0X_Dev *dev)
+{
+    /* Restaura a stop variable capturada no init antes de cada start */
+    if(VL53L0X_WriteSequence(dev, stop_variable_open, sizeof(stop_variable_open) / sizeof(stop_variable_open[0])) != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    if(VL53L0X_WriteReg(dev, 0x91, dev->stopVariable) != VL53L0X_OK) {
         return VL53L0X_ERROR;
     }
     
-    return VL53L0X_OK;
+    return VL53L0X_WriteSequence(dev, stop_variable_close, sizeof(stop_variable_close) / sizeof(stop_variable_close[0]));
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "vl53l0x_calib.h"
+#include <string.h>
+#include <stddef.h>
+
+/* Registro gravado na flash */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    VL53L0X_Calibration calib;
+    uint32_t crc;
+} VL53L0X_CalibRecord;
+
+/* Private function prototypes */
+static uint32_t VL53L0X_Calib_Crc32(const uint8_t *data, uint32_t length);
+
+bool VL53L0X_Calib_Load(uint8_t slot, VL53L0X_Calibration *calib)
+{
+    const VL53L0X_CalibRecord *record;
+    
+    if(slot >= VL53L0X_CALIB_SLOTS) {
+        return false;
+    }
+    record = (const VL53L0X_CalibRecord *)VL53L0X_CALIB_FLASH_ADDR + slot;
+    
+    if(record->magic != VL53L0X_CALIB_MAGIC ||
+       record->version != VL53L0X_CALIB_VERSION ||
+       record->size != sizeof(VL53L0X_Calibration)) {
+        return false;
+    }
+    
+    /* CRC cobre tudo antes do próprio campo crc */
+    if(record->crc != VL53L0X_Calib_Crc32((const uint8_t *)record, offsetof(VL53L0X_CalibRecord, crc))) {
+        return false;
+    }
+    
+    memcpy(calib, &record->calib, sizeof(VL53L0X_Calibration));
+    
+    return true;
+}
+
+VL53L0X_Status VL53L0X_Calib_Save(uint8_t slot, const VL53L0X_Calibration *calib)
+{
+    VL53L0X_CalibRecord records[VL53L0X_CALIB_SLOTS];
+    VL53L0X_CalibRecord *record;
+    const uint16_t *halfwords = (const uint16_t *)records;
+    HAL_StatusTypeDef status;
+    
+    if(slot >= VL53L0X_CALIB_SLOTS) {
+        return VL53L0X_ERROR;
+    }
+    record = &records[slot];
+    
+    /* A página é apagada inteira: preserva os registros dos outros sensores */
+    memcpy(records, (const void *)VL53L0X_CALIB_FLASH_ADDR, sizeof(records));
+    
+    memset(record, 0xFF, sizeof(VL53L0X_CalibRecord));
+    record->magic = VL53L0X_CALIB_MAGIC;
+    record->version = VL53L0X_CALIB_VERSION;
+    record->size = sizeof(VL53L0X_Calibration);
+    memcpy(&record->calib, calib, sizeof(VL53L0X_Calibration));
+    record->crc = VL53L0X_Calib_Crc32((const uint8_t *)record, offsetof(VL53L0X_CalibRecord, crc));
+    
+    if(VL53L0X_Calib_Erase() != VL53L0X_OK) {
+        return VL53L0X_ERROR;
+    }
+    
+    HAL_FLASH_Unlock();
+    
+    /* F1 programa a flash em meias-palavras; 0xFFFF já é o valor apagado */
+    status = HAL_OK;
+    for(uint32_t i = 0; i < sizeof(records) / 2 && status == HAL_OK; i++) {
+        if(halfwords[i] != 0xFFFF) {
+            status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, VL53L0X_CALIB_FLASH_ADDR + i * 2, halfwords[i]);
+        }
+    }
+    
+    HAL_FLASH_Lock();
+    
+    return (status == HAL_OK) ? VL53L0X_OK : VL53L0X_ERROR;
+}
+
+VL53L0X_Status VL53L0X_Calib_Erase(void)
+{
+    FLASH_EraseInitTypeDef erase = {0};
+    uint32_t page_error = 0;
+    HAL_StatusTypeDef status;
+    
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = VL53L0X_CALIB_FLASH_ADDR;
+    erase.NbPages = 1;
+    
+    HAL_FLASH_Unlock();
+    status = HAL_FLASHEx_Erase(&erase, &page_error);
+    HAL_FLASH_Lock();
+    
+    return (status == HAL_OK) ? VL53L0X_OK : VL53L0X_ERROR;
+}
+
+/* Private Functions */
+
+/* CRC-32 (polinômio 0xEDB88320), bit a bit para não gastar flash com tabela */
+static uint32_t VL53L0X_Calib_Crc32(const uint8_t *data, uint32_t length)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    
+    for(uint32_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    
+    return ~crc;
+}
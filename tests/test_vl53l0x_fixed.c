@@ -0,0 +1,146 @@
+/* Testes de host de vl53l0x_fixed.h contra referências em double.
+   Compilar e rodar com "make" neste diretório (não depende da HAL). */
+#include "vl53l0x_fixed.h"
+#include <math.h>
+#include <stdio.h>
+
+/* O header só usa aritmética de 32 bits (uint32_t e literais U), então o host
+   calcula o mesmo que o Cortex-M3 desde que unsigned int tenha 32 bits */
+typedef char assert_unsigned_is_32_bits[(sizeof(unsigned int) == 4) ? 1 : -1];
+
+static unsigned failures = 0;
+static unsigned checks = 0;
+
+#define CHECK_EQ(got, expected, fmt, ...) do { \
+    unsigned long long got_ = (unsigned long long)(got); \
+    unsigned long long expected_ = (unsigned long long)(expected); \
+    checks++; \
+    if(got_ != expected_) { \
+        failures++; \
+        if(failures <= 20) { \
+            printf("FALHA %s:%d: %llu != %llu (" fmt ")\n", __FILE__, __LINE__, got_, expected_, __VA_ARGS__); \
+        } \
+    } \
+} while(0)
+
+/* Gerador determinístico (LCG) para amostras aleatórias reprodutíveis */
+static uint32_t rng_state = 12345;
+
+static uint32_t Rand32(void)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return rng_state;
+}
+
+/* Arredondamento meio para cima, como o driver */
+static double RoundHalfUp(double x)
+{
+    return floor(x + 0.5);
+}
+
+static void Test_FP97To1616(void)
+{
+    for(uint32_t v = 0; v <= 0xFFFF; v++) {
+        double ref = (v / 128.0) * 65536.0;
+        CHECK_EQ(VL53L0X_FP97To1616((VL53L0X_FixPt97)v), ref, "v=0x%04X", (unsigned)v);
+    }
+}
+
+static void Test_FP1616ToInt(void)
+{
+    /* 0xFFFF8000 e acima: regressão da soma do arredondamento que dava a
+       volta em 32 bits e retornava 0 no alvo */
+    static const uint32_t edges[] = {
+        0, 0x7FFF, 0x8000, 0x8001, 0xFFFF, 0x10000, 0x17FFF, 0x18000,
+        0xFFFE8000, 0xFFFF0000, 0xFFFF7FFF, 0xFFFF8000, 0xFFFFFFFF
+    };
+    
+    for(unsigned i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        double ref = fmin(RoundHalfUp(edges[i] / 65536.0), 0xFFFF);
+        CHECK_EQ(VL53L0X_FP1616ToInt(edges[i]), ref, "v=0x%08X", (unsigned)edges[i]);
+    }
+    for(unsigned i = 0; i < 200000; i++) {
+        uint32_t v = Rand32();
+        double ref = fmin(RoundHalfUp(v / 65536.0), 0xFFFF);
+        CHECK_EQ(VL53L0X_FP1616ToInt(v), ref, "v=0x%08X", (unsigned)v);
+    }
+}
+
+static void Test_ISqrt(void)
+{
+    static const uint32_t edges[] = {
+        0, 1, 2, 3, 4, 15, 16, 17, 65535, 65536, 0x3FFFFFFF, 0x40000000,
+        0xFFFE0001, 0xFFFE0000, 0xFFFFFFFF
+    };
+    
+    for(unsigned i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        CHECK_EQ(VL53L0X_ISqrt(edges[i]), floor(sqrt((double)edges[i])), "n=%u", (unsigned)edges[i]);
+    }
+    for(uint32_t n = 0; n < 100000; n++) {
+        CHECK_EQ(VL53L0X_ISqrt(n), floor(sqrt((double)n)), "n=%u", (unsigned)n);
+    }
+    for(unsigned i = 0; i < 200000; i++) {
+        uint32_t n = Rand32();
+        CHECK_EQ(VL53L0X_ISqrt(n), floor(sqrt((double)n)), "n=%u", (unsigned)n);
+    }
+}
+
+/* Macro período de referência em ns: 2304 * PCLKs * 1.655ns */
+static double MacroPeriodNs(uint8_t pclks)
+{
+    return VL53L0X_MACRO_PERIOD_VCLKS * pclks * (VL53L0X_PLL_PERIOD_PS / 1000.0);
+}
+
+static void Test_Timeouts(void)
+{
+    static const uint32_t mclks_edges[] = { 0, 1, 2, 499, 500, 1000, 0x7FFF, 0xFFFF, 0x10000, 1000000 };
+    static const uint32_t us_edges[] = { 0, 1, 10, 999, 20000, 33000, 200000, 500000, 1000000, 4000000 };
+    
+    for(uint8_t pclks = 8; pclks <= 18; pclks += 2) {
+        uint32_t macro_ns = VL53L0X_CalcMacroPeriod(pclks);
+        
+        CHECK_EQ(macro_ns, RoundHalfUp(MacroPeriodNs(pclks)), "pclks=%u", (unsigned)pclks);
+    
+        /* MCLKs -> µs, incluindo o caso longo com 18 PCLKs (65535 * 68636ns > 2^32) */
+        for(unsigned i = 0; i < sizeof(mclks_edges) / sizeof(mclks_edges[0]); i++) {
+            double ref = RoundHalfUp((double)mclks_edges[i] * macro_ns / 1000.0);
+            CHECK_EQ(VL53L0X_TimeoutMclksToMicroseconds(mclks_edges[i], pclks), ref,
+                     "mclks=%u pclks=%u", (unsigned)mclks_edges[i], (unsigned)pclks);
+        }
+        for(unsigned i = 0; i < 20000; i++) {
+            uint32_t mclks = Rand32() % 1000001;
+            double ref = RoundHalfUp((double)mclks * macro_ns / 1000.0);
+            CHECK_EQ(VL53L0X_TimeoutMclksToMicroseconds(mclks, pclks), ref, "mclks=%u pclks=%u",
+                     (unsigned)mclks, (unsigned)pclks);
+        }
+    
+        /* µs -> MCLKs (timeout_us < 4.29s) */
+        for(unsigned i = 0; i < sizeof(us_edges) / sizeof(us_edges[0]); i++) {
+            double ref = RoundHalfUp((double)us_edges[i] * 1000.0 / macro_ns);
+            CHECK_EQ(VL53L0X_TimeoutMicrosecondsToMclks(us_edges[i], pclks), ref,
+                     "us=%u pclks=%u", (unsigned)us_edges[i], (unsigned)pclks);
+        }
+        for(unsigned i = 0; i < 20000; i++) {
+            uint32_t us = Rand32() % 4000001;
+            uint32_t mclks = VL53L0X_TimeoutMicrosecondsToMclks(us, pclks);
+            double ref = RoundHalfUp((double)us * 1000.0 / macro_ns);
+            CHECK_EQ(mclks, ref, "us=%u pclks=%u", (unsigned)us, (unsigned)pclks);
+    
+            /* Ida e volta dentro de meio macro período */
+            double back = VL53L0X_TimeoutMclksToMicroseconds(mclks, pclks);
+            CHECK_EQ(fabs(back - us) <= macro_ns / 2000.0 + 1.0, 1, "us=%u pclks=%u", (unsigned)us, (unsigned)pclks);
+        }
+    }
+}
+
+int main(void)
+{
+    Test_FP97To1616();
+    Test_FP1616ToInt();
+    Test_ISqrt();
+    Test_Timeouts();
+    
+    printf("%u verificações, %u falhas\n", checks, failures);
+    
+    return (failures == 0) ? 0 : 1;
+}